@@ -0,0 +1,75 @@
+// Moving average example and benchmark.
+// Compares re-summing a ring_buffer window for every sample against sliding_window's
+// O(1) updates, for a few window sizes.
+// Build and run with: make examples && bin/release/moving_average
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "ring_buffer.h"
+#include "sliding_window.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static double elapsed_ms(clock_type::time_point start) {
+	return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+template<int Window> void run(const std::vector<float>& samples) {
+	// Baseline: push into a ring_buffer and re-sum the whole window every sample
+	double checksum_naive = 0;
+	auto start = clock_type::now();
+	{
+		bsp::ring_buffer<float, Window> ring;
+		for (float x : samples) {
+			ring.push_back(x);
+			double sum = 0;
+			for (float y : ring) sum += y;
+			checksum_naive += sum / ring.count();
+		}
+	}
+	const double naive_ms = elapsed_ms(start);
+
+	double checksum_window = 0;
+	start = clock_type::now();
+	{
+		bsp::sliding_window<float, Window> window;
+		for (float x : samples) {
+			window.push(x);
+			checksum_window += window.mean();
+		}
+	}
+	const double window_ms = elapsed_ms(start);
+
+	// Batched updates, reading the aggregates once per block
+	const int block = 64;
+	double checksum_batch = 0;
+	start = clock_type::now();
+	{
+		bsp::sliding_window<float, Window> window;
+		for (size_t i = 0; i + block <= samples.size(); i += block) {
+			window.push_n(samples.begin() + i, block);
+			checksum_batch += window.mean() + window.stddev() + window.max() - window.min();
+		}
+	}
+	const double batch_ms = elapsed_ms(start);
+
+	std::printf("window %5d: re-sum %9.2f ms, sliding_window %7.2f ms (%6.1fx), push_n + all aggregates %7.2f ms  [checksums %.1f %.1f %.1f]\n",
+				Window, naive_ms, window_ms, naive_ms / window_ms, batch_ms, checksum_naive, checksum_window, checksum_batch);
+}
+
+int main() {
+	const int num_samples = 1 << 20;
+	std::vector<float> samples(num_samples);
+	std::default_random_engine engine { 42 };
+	std::normal_distribution<float> distribution { 0.0f, 1.0f };
+	for (auto& x : samples) x = distribution(engine);
+
+	std::printf("Moving average over %d samples\n", num_samples);
+	run<16>(samples);
+	run<256>(samples);
+	run<4096>(samples);
+	return 0;
+}
@@ -0,0 +1,606 @@
+// Ring buffers that can be shared between threads.
+// Customise the behaviour by defining these before including it:
+// #define BSP_CACHE_LINE_SIZE to change the alignment used to separate shared cursors (default 64)
+// #define BSP_CPU_RELAX() to change the pause instruction used by spinning waits
+
+#ifndef BSP_CONCURRENT_RING_BUFFER_H
+#define BSP_CONCURRENT_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifndef BSP_CACHE_LINE_SIZE
+#define BSP_CACHE_LINE_SIZE 64
+#endif
+
+#ifndef BSP_CPU_RELAX
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define BSP_CPU_RELAX() _mm_pause()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define BSP_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define BSP_CPU_RELAX() ((void) 0)
+#endif
+#endif
+
+namespace bsp {
+
+// A lock-free ring buffer for exactly one producer thread and one consumer thread.
+// The producer owns tail_ and the consumer owns head_; each lives on its own cache line
+// together with a cached copy of the other cursor, so the shared line is only read when
+// the cached value says the ring looks full (producer) or empty (consumer).
+// Cursors are free-running and wrap naturally, elements are constructed in place.
+template<typename T, int Capacity> class spsc_ring_buffer {
+	static_assert(Capacity > 0, "Capacity <= 0!");
+
+public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = int;
+
+public:
+	spsc_ring_buffer() = default;
+
+	spsc_ring_buffer(const spsc_ring_buffer&) = delete;
+	spsc_ring_buffer& operator=(const spsc_ring_buffer&) = delete;
+
+	~spsc_ring_buffer() {
+		while (try_pop_destroy()) {}
+	}
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	// Producer: returns false if the ring is full
+	bool try_push(const T& value) { return try_emplace(value); }
+
+	bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+	template<class... Args> bool try_emplace(Args&&... args) {
+		const cursor_type tail = tail_.load(std::memory_order_relaxed);
+		if (tail - cached_head_ == static_cast<cursor_type>(Capacity)) {
+			cached_head_ = head_.load(std::memory_order_acquire);
+			if (tail - cached_head_ == static_cast<cursor_type>(Capacity)) return false;
+		}
+		new (slot(tail)) T(std::forward<Args>(args)...);
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer: returns false if the ring is empty
+	bool try_pop(T& value) {
+		T* front = try_front();
+		if (front == nullptr) return false;
+		value = std::move(*front);
+		pop_front();
+		return true;
+	}
+
+	// Consumer: peek at the oldest element, or nullptr if the ring is empty
+	// The element stays valid until pop_front()
+	T* try_front() {
+		const cursor_type head = head_.load(std::memory_order_relaxed);
+		if (head == cached_tail_) {
+			cached_tail_ = tail_.load(std::memory_order_acquire);
+			if (head == cached_tail_) return nullptr;
+		}
+		return slot(head);
+	}
+
+	// Consumer: requires try_front() != nullptr
+	void pop_front() {
+		const cursor_type head = head_.load(std::memory_order_relaxed);
+		assert(head != tail_.load(std::memory_order_acquire));
+		slot(head)->~T();
+		head_.store(head + 1, std::memory_order_release);
+	}
+
+	// Approximate when called concurrently with the other thread
+	size_type count() const {
+		const cursor_type head = head_.load(std::memory_order_acquire);
+		const cursor_type tail = tail_.load(std::memory_order_acquire);
+		return static_cast<size_type>(tail - head);
+	}
+
+	bool empty() const { return count() == 0; }
+
+protected:
+	using cursor_type = std::size_t;
+	using raw_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	// Consumer line
+	alignas(BSP_CACHE_LINE_SIZE) std::atomic<cursor_type> head_ {0};
+	cursor_type cached_tail_ = 0;
+
+	// Producer line
+	alignas(BSP_CACHE_LINE_SIZE) std::atomic<cursor_type> tail_ {0};
+	cursor_type cached_head_ = 0;
+
+	alignas(BSP_CACHE_LINE_SIZE) raw_type data_[Capacity];
+
+protected:
+	T* slot(cursor_type cursor) {
+		return reinterpret_cast<T*>(data_ + cursor % static_cast<cursor_type>(Capacity));
+	}
+
+	bool try_pop_destroy() {
+		if (try_front() == nullptr) return false;
+		pop_front();
+		return true;
+	}
+};
+
+// A bounded lock-free ring buffer for any number of producer and consumer threads.
+// Based on Dmitry Vyukov's bounded MPMC queue: every slot carries a sequence number
+// that tells producers when the slot is free and consumers when it is full, so the
+// only shared writes are a CAS on head_ or tail_ and the slot itself.
+// Storage is fixed at compile time, nothing is allocated after construction.
+// Capacity must be at least 2: with a single slot, the sequence a full slot holds equals the
+// next push's tail, so a second push would overwrite the element.
+template<typename T, int Capacity> class mpmc_ring_buffer {
+	static_assert(Capacity >= 2, "mpmc_ring_buffer: Capacity < 2!");
+
+public:
+	using value_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = int;
+
+public:
+	mpmc_ring_buffer() {
+		for (cursor_type i = 0; i < static_cast<cursor_type>(Capacity); ++i) {
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	mpmc_ring_buffer(const mpmc_ring_buffer&) = delete;
+	mpmc_ring_buffer& operator=(const mpmc_ring_buffer&) = delete;
+
+	~mpmc_ring_buffer() {
+		const cursor_type tail = tail_.load(std::memory_order_relaxed);
+		for (cursor_type head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+			cell(head).value()->~T();
+		}
+	}
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	// Returns false if the ring is full
+	bool try_push(const T& value) { return try_emplace(value); }
+
+	bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+	template<class... Args> bool try_emplace(Args&&... args) {
+		cursor_type tail = tail_.load(std::memory_order_relaxed);
+		while (true) {
+			cell_type& c = cell(tail);
+			const cursor_type sequence = c.sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::ptrdiff_t>(sequence - tail);
+			if (diff == 0) {
+				if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+					new (c.value()) T(std::forward<Args>(args)...);
+					c.sequence.store(tail + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0) {
+				return false; // Slot still holds the value from the previous lap
+			}
+			else {
+				tail = tail_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Returns false if the ring is empty
+	bool try_pop(T& value) {
+		cursor_type head = head_.load(std::memory_order_relaxed);
+		while (true) {
+			cell_type& c = cell(head);
+			const cursor_type sequence = c.sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::ptrdiff_t>(sequence - (head + 1));
+			if (diff == 0) {
+				if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+					value = std::move(*c.value());
+					c.value()->~T();
+					c.sequence.store(head + static_cast<cursor_type>(Capacity), std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0) {
+				return false; // Slot hasn't been written in this lap
+			}
+			else {
+				head = head_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Approximate when called concurrently
+	size_type count() const {
+		const cursor_type head = head_.load(std::memory_order_acquire);
+		const cursor_type tail = tail_.load(std::memory_order_acquire);
+		return tail > head ? static_cast<size_type>(tail - head) : 0;
+	}
+
+	bool empty() const { return count() == 0; }
+
+protected:
+	using cursor_type = std::size_t;
+	using raw_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	struct cell_type {
+		std::atomic<cursor_type> sequence;
+		raw_type storage;
+
+		T* value() { return reinterpret_cast<T*>(&storage); }
+	};
+
+	alignas(BSP_CACHE_LINE_SIZE) std::atomic<cursor_type> head_ {0};
+	alignas(BSP_CACHE_LINE_SIZE) std::atomic<cursor_type> tail_ {0};
+	alignas(BSP_CACHE_LINE_SIZE) cell_type cells_[Capacity];
+
+protected:
+	cell_type& cell(cursor_type cursor) {
+		return cells_[cursor % static_cast<cursor_type>(Capacity)];
+	}
+};
+
+// How a broadcast_ring_buffer's writer treats a consumer that has fallen a full lap behind
+enum class broadcast_policy {
+	backpressure, // try_push fails until the slowest consumer catches up
+	overwrite	  // The writer never waits, lapped consumers skip ahead and count the lost events
+};
+
+// A ring buffer with one writer thread and Consumers reader threads that each see every event.
+// Events are written once into shared slots and every consumer keeps its own read cursor on
+// its own cache line, in the style of the LMAX disruptor. With backpressure the writer tracks a
+// cached minimum of the consumer cursors and only rescans them when the ring looks full; with
+// overwrite the writer never reads them at all. With overwrite, slots are held as atomic words
+// so consumers can copy an event while the writer overwrites it and discard the torn copy.
+// Consumers are identified by an index in [0, Consumers), each index must be used by one thread.
+template<typename T, int Capacity, int Consumers, broadcast_policy Policy = broadcast_policy::backpressure>
+class broadcast_ring_buffer {
+	static_assert(Capacity > 0, "Capacity <= 0!");
+	static_assert(Consumers > 0, "Consumers <= 0!");
+	static_assert(Policy == broadcast_policy::backpressure || std::is_trivially_copyable<T>::value,
+				  "broadcast_ring_buffer: overwrite requires a trivially copyable T");
+
+public:
+	using value_type = T;
+	using const_reference = const T&;
+	using size_type = int;
+
+public:
+	broadcast_ring_buffer() = default;
+
+	broadcast_ring_buffer(const broadcast_ring_buffer&) = delete;
+	broadcast_ring_buffer& operator=(const broadcast_ring_buffer&) = delete;
+
+	~broadcast_ring_buffer() {
+		const cursor_type tail = tail_.load(std::memory_order_relaxed);
+		const cursor_type first = tail > static_cast<cursor_type>(Capacity) ? tail - static_cast<cursor_type>(Capacity) : 0;
+		if (Policy == broadcast_policy::backpressure)
+			for (cursor_type cursor = first; cursor != tail; ++cursor) slot(cursor)->~T();
+	}
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	static constexpr inline size_type consumers() { return Consumers; }
+
+	// Writer: returns false if the slowest consumer is a full lap behind (backpressure only)
+	bool try_push(const T& value) { return try_emplace(value); }
+
+	bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+	template<class... Args> bool try_emplace(Args&&... args) {
+		const cursor_type tail = tail_.load(std::memory_order_relaxed);
+		if (Policy == broadcast_policy::backpressure) {
+			if (tail - cached_min_head_ == static_cast<cursor_type>(Capacity)) {
+				cached_min_head_ = min_head(tail);
+				if (tail - cached_min_head_ == static_cast<cursor_type>(Capacity)) return false;
+			}
+		}
+		write(tail, std::integral_constant<bool, Policy == broadcast_policy::backpressure>(), std::forward<Args>(args)...);
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer: the oldest event this consumer hasn't read, or nullptr if it is up to date
+	// The event is read in place and stays valid until pop_front(consumer) (backpressure only)
+	const T* try_front(size_type consumer) {
+		static_assert(Policy == broadcast_policy::backpressure, "broadcast_ring_buffer: try_front requires backpressure");
+		reader& r = reader_for(consumer);
+		const cursor_type head = r.head.load(std::memory_order_relaxed);
+		if (head == r.cached_tail) {
+			r.cached_tail = tail_.load(std::memory_order_acquire);
+			if (head == r.cached_tail) return nullptr;
+		}
+		return slot(head);
+	}
+
+	// Consumer: requires try_front(consumer) != nullptr
+	void pop_front(size_type consumer) {
+		static_assert(Policy == broadcast_policy::backpressure, "broadcast_ring_buffer: pop_front requires backpressure");
+		reader& r = reader_for(consumer);
+		r.head.store(r.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer: calls fn(const T&) in place for up to max_count available events then releases
+	// them all with a single cursor update, returns the number consumed (backpressure only)
+	template<typename Fn> size_type consume(size_type consumer, Fn fn, size_type max_count = Capacity) {
+		static_assert(Policy == broadcast_policy::backpressure, "broadcast_ring_buffer: consume requires backpressure");
+		reader& r = reader_for(consumer);
+		const cursor_type head = r.head.load(std::memory_order_relaxed);
+		r.cached_tail = tail_.load(std::memory_order_acquire);
+		const size_type n = std::min(static_cast<size_type>(r.cached_tail - head), max_count);
+		for (size_type i = 0; i < n; ++i) fn(static_cast<const T&>(*slot(head + static_cast<cursor_type>(i))));
+		r.head.store(head + static_cast<cursor_type>(n), std::memory_order_release);
+		return n;
+	}
+
+	// Consumer: copies out the oldest unread event, returns false if it is up to date
+	// With overwrite, events the writer lapped are skipped and added to dropped(consumer)
+	bool try_pop(size_type consumer, T& value) {
+		return try_pop(consumer, value, std::integral_constant<bool, Policy == broadcast_policy::backpressure>());
+	}
+
+	// Events this consumer hasn't read yet, approximate when called concurrently with the writer
+	size_type count(size_type consumer) const {
+		const cursor_type head = readers_[consumer].head.load(std::memory_order_acquire);
+		const cursor_type tail = tail_.load(std::memory_order_acquire);
+		return static_cast<size_type>(std::min(tail - head, static_cast<cursor_type>(Capacity)));
+	}
+
+	bool empty(size_type consumer) const { return count(consumer) == 0; }
+
+	// Events overwritten before this consumer read them (overwrite only)
+	std::size_t dropped(size_type consumer) const { return readers_[consumer].dropped.load(std::memory_order_relaxed); }
+
+protected:
+	using cursor_type = std::size_t;
+	using word_type = std::size_t;
+	static constexpr std::size_t num_words = (sizeof(T) + sizeof(word_type) - 1) / sizeof(word_type);
+
+	// An overwrite slot: the event's bytes, copied in and out one relaxed atomic word at a time
+	struct atomic_slot {
+		std::atomic<word_type> words[num_words];
+	};
+
+	using raw_type = typename std::conditional<Policy == broadcast_policy::backpressure,
+											   typename std::aligned_storage<sizeof(T), alignof(T)>::type, atomic_slot>::type;
+
+	struct alignas(BSP_CACHE_LINE_SIZE) reader {
+		std::atomic<cursor_type> head {0};
+		cursor_type cached_tail = 0;
+		std::atomic<std::size_t> dropped {0}; // Written by the consumer only, read by dropped()
+	};
+
+	// Writer line
+	alignas(BSP_CACHE_LINE_SIZE) std::atomic<cursor_type> tail_ {0};
+	cursor_type cached_min_head_ = 0;
+
+	reader readers_[Consumers];
+
+	alignas(BSP_CACHE_LINE_SIZE) raw_type data_[Capacity];
+
+protected:
+	T* slot(cursor_type cursor) {
+		return reinterpret_cast<T*>(data_ + cursor % static_cast<cursor_type>(Capacity));
+	}
+
+	atomic_slot& words(cursor_type cursor) {
+		return data_[cursor % static_cast<cursor_type>(Capacity)];
+	}
+
+	template<class... Args> void write(cursor_type tail, std::true_type /*backpressure*/, Args&&... args) {
+		if (tail >= static_cast<cursor_type>(Capacity)) slot(tail)->~T(); // Every consumer is done with it
+		new (slot(tail)) T(std::forward<Args>(args)...);
+	}
+
+	template<class... Args> void write(cursor_type tail, std::false_type /*backpressure*/, Args&&... args) {
+		const T value(std::forward<Args>(args)...);
+		word_type buffer[num_words] = {};
+		std::memcpy(buffer, &value, sizeof(T));
+		// Readers validate against tail_ after copying, so order the previous publish before this write
+		std::atomic_thread_fence(std::memory_order_release);
+		atomic_slot& target = words(tail);
+		for (std::size_t i = 0; i < num_words; ++i) target.words[i].store(buffer[i], std::memory_order_relaxed);
+	}
+
+	reader& reader_for(size_type consumer) {
+		assert(consumer >= 0 && consumer < Consumers);
+		return readers_[consumer];
+	}
+
+	bool try_pop(size_type consumer, T& value, std::true_type /*backpressure*/) {
+		const T* front = try_front(consumer);
+		if (front == nullptr) return false;
+		value = *front;
+		pop_front(consumer);
+		return true;
+	}
+
+	bool try_pop(size_type consumer, T& value, std::false_type /*backpressure*/) {
+		reader& r = reader_for(consumer);
+		cursor_type head = r.head.load(std::memory_order_relaxed);
+		while (true) {
+			cursor_type tail = tail_.load(std::memory_order_acquire);
+			if (head == tail) return false;
+			// The writer may be writing slot(tail), which is the slot of tail - Capacity
+			if (tail - head >= static_cast<cursor_type>(Capacity)) {
+				const cursor_type oldest = tail - static_cast<cursor_type>(Capacity) + 1;
+				r.dropped.store(r.dropped.load(std::memory_order_relaxed) + (oldest - head), std::memory_order_relaxed);
+				head = oldest;
+			}
+			// The copy may be torn by the writer lapping us, it is only used once validated below
+			word_type buffer[num_words];
+			const atomic_slot& source = words(head);
+			for (std::size_t i = 0; i < num_words; ++i) buffer[i] = source.words[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			tail = tail_.load(std::memory_order_relaxed);
+			if (tail - head < static_cast<cursor_type>(Capacity)) { // Not overwritten while copying
+				std::memcpy(&value, buffer, sizeof(T));
+				break;
+			}
+		}
+		r.head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	cursor_type min_head(cursor_type tail) const {
+		cursor_type min = tail;
+		for (const reader& r : readers_) {
+			const cursor_type head = r.head.load(std::memory_order_acquire);
+			if (tail - head > tail - min) min = head;
+		}
+		return min;
+	}
+};
+
+// Wait strategies for blocking_ring_buffer, trading wake-up latency against CPU use.
+// wait(ready) blocks until ready() returns true, ready() retries the queue operation.
+// signal(available) is called after the opposite operation, available() returns how many
+// elements (or free slots) a waiter could now take and is only evaluated when needed.
+
+// Never gives up the core: lowest latency, burns a full core per waiting thread
+struct busy_spin_wait {
+	template<typename Ready> void wait(Ready ready) {
+		while (!ready()) BSP_CPU_RELAX();
+	}
+
+	template<typename Available> void signal(Available) {}
+};
+
+// Spins for Spins attempts then yields the core between attempts
+template<int Spins = 100> struct spin_yield_wait {
+	template<typename Ready> void wait(Ready ready) {
+		for (int i = 0; i < Spins; ++i) {
+			if (ready()) return;
+			BSP_CPU_RELAX();
+		}
+		while (!ready()) std::this_thread::yield();
+	}
+
+	template<typename Available> void signal(Available) {}
+};
+
+// Spins briefly then sleeps on a condition variable. The signalling side only takes the
+// lock when a thread is asleep and at least BatchSize elements are available, so a sleeper
+// is woken once per batch instead of once per element. Sleepers also wake up after
+// MaxDelayMicroseconds, which bounds the latency of a batch that never fills up.
+template<int BatchSize = 1, int MaxDelayMicroseconds = 1000, int Spins = 100> class sleeping_wait {
+	static_assert(BatchSize > 0, "BatchSize <= 0!");
+
+public:
+	template<typename Ready> void wait(Ready ready) {
+		for (int i = 0; i < Spins; ++i) {
+			if (ready()) return;
+			BSP_CPU_RELAX();
+		}
+		std::unique_lock<std::mutex> lock(mutex_);
+		sleepers_.fetch_add(1);
+		// Pairs with the fence in signal(): either the signaller sees this sleeper or ready() sees its element
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (!ready()) condition_.wait_for(lock, std::chrono::microseconds(MaxDelayMicroseconds));
+		sleepers_.fetch_sub(1);
+	}
+
+	template<typename Available> void signal(Available available) {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+		if (BatchSize > 1 && available() < BatchSize) return;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+		}
+		condition_.notify_all();
+	}
+
+protected:
+	std::atomic<int> sleepers_ {0};
+	std::mutex mutex_;
+	std::condition_variable condition_;
+};
+
+// An mpmc_ring_buffer whose push and pop block until they succeed, using WaitStrategy to
+// wait for elements and for free slots. Pick the strategy per queue.
+template<typename T, int Capacity, typename WaitStrategy = spin_yield_wait<>> class blocking_ring_buffer {
+	static_assert(Capacity >= 2, "blocking_ring_buffer: Capacity < 2, see mpmc_ring_buffer");
+
+public:
+	using value_type = T;
+	using size_type = int;
+	using wait_strategy = WaitStrategy;
+
+public:
+	blocking_ring_buffer() = default;
+
+	blocking_ring_buffer(const blocking_ring_buffer&) = delete;
+	blocking_ring_buffer& operator=(const blocking_ring_buffer&) = delete;
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	// Blocks while the ring is full
+	void push(const T& value) {
+		not_full_.wait([&]() { return queue_.try_push(value); });
+		signal_not_empty();
+	}
+
+	void push(T&& value) {
+		// try_push only moves from value when it succeeds
+		not_full_.wait([&]() { return queue_.try_push(std::move(value)); });
+		signal_not_empty();
+	}
+
+	// Blocks while the ring is empty
+	void pop(T& value) {
+		not_empty_.wait([&]() { return queue_.try_pop(value); });
+		signal_not_full();
+	}
+
+	bool try_push(const T& value) {
+		if (!queue_.try_push(value)) return false;
+		signal_not_empty();
+		return true;
+	}
+
+	bool try_pop(T& value) {
+		if (!queue_.try_pop(value)) return false;
+		signal_not_full();
+		return true;
+	}
+
+	// Approximate when called concurrently
+	size_type count() const { return queue_.count(); }
+
+	bool empty() const { return queue_.empty(); }
+
+protected:
+	mpmc_ring_buffer<T, Capacity> queue_;
+	WaitStrategy not_empty_;
+	WaitStrategy not_full_;
+
+protected:
+	void signal_not_empty() {
+		not_empty_.signal([this]() { return queue_.count(); });
+	}
+
+	void signal_not_full() {
+		not_full_.signal([this]() { return Capacity - queue_.count(); });
+	}
+};
+
+} // namespace bsp
+
+#endif
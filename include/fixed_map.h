@@ -3,11 +3,14 @@
 
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <iterator>
 #include <ostream>
 #include <stdexcept>
+#include <utility>
 
 namespace bsp {
 
@@ -23,17 +26,37 @@ struct is_iterator<
 	: std::true_type {};
 } // namespace detail
 
+// How fixed_map places a key whose home slot is taken
+enum class probing {
+	linear,    // In the first free slot after the home slot
+	robin_hood // Probe runs are kept sorted by distance from home: an insert takes the slot of any
+			   // element closer to its home than the new one and moves that one on instead.
+			   // This evens out probe lengths, and a lookup can give up as soon as it reaches an
+			   // element closer to its home than the key would be. Each slot stores its distance.
+};
+
+namespace detail {
+template<probing> struct fixed_map_slot_base {};
+template<> struct fixed_map_slot_base<probing::robin_hood> {
+	int probe_distance = 0; // Steps from the element's home slot
+};
+} // namespace detail
+
 // A simple map of elements stored in a fixed-size array.
 // Is essentially a hashmap with open addressing and linear probing.
-template<typename Key, typename T, int Capacity, class Hash = std::hash<Key>> 
+// Every slot also stores an 8-bit fingerprint of its key's hash, so lookups skip most
+// non-matching slots without comparing keys, and stop at the first empty slot.
+// Use probing::robin_hood when the hash clusters keys (e.g. std::hash of integers with patterns).
+template<typename Key, typename T, int Capacity, class Hash = std::hash<Key>, probing Probing = probing::linear>
 class fixed_map {
 	static_assert(Capacity > 0, "Capacity <= 0!");
 
 public:
-	struct slot {
+	struct slot : detail::fixed_map_slot_base<Probing> {
 		Key key;
 		T value;
 		bool valid = false;
+		std::uint8_t fingerprint = 0;
 	};
 
 	using array_type = std::array<slot, Capacity>;
@@ -47,6 +70,8 @@ public:
 	using const_iterator = typename array_type::const_iterator;
 	using size_type = int;
 
+	static const probing probing_mode = Probing;
+
 public:
 	fixed_map(const T& invalid_value = T()) : size_(0), invalid_value_(invalid_value) { clear(); }
 
@@ -90,23 +115,23 @@ public:
 		if (size_ >= max_size()) {
 			throw std::length_error("fixed_map: trying to insert too many elements");
 		}
-		size_type index = hash_to_index(key);
-		size_type oindex = index;
-		while (data_[index].valid) {
-			index = (index + 1) % max_size();
-			if (index == oindex) {
-				// TODO: This should be unreachable?
-				assert(false);
-				return begin();
-			}
-		}
-		data_[index].key = key;
-		data_[index].value = value;
-		data_[index].valid = true;
+		const size_type index = insert_new(key, value, hash(key), is_robin_hood());
 		size_++;
 		return std::next(data_.begin(), index);
 	}
 
+	// Removes the element with key, returns the number of elements removed (0 or 1)
+	// Uses backward-shift deletion: the following elements of the probe run move back into
+	// the hole, so no tombstones are left and probe runs stay as short as if the erased
+	// element had never been inserted.
+	size_type erase(const key_type& key) {
+		const size_type index = find_index(key);
+		if (index == -1) return 0;
+		erase_at(index, is_robin_hood());
+		size_--;
+		return 1;
+	}
+
 	iterator begin() { return data_.begin(); }
 	iterator end() { return begin() + max_size(); }
 
@@ -119,6 +144,8 @@ protected:
 	T invalid_value_;
 
 protected:
+	using is_robin_hood = std::integral_constant<bool, Probing == probing::robin_hood>;
+
 	template<typename Iter,
 			 typename = typename std::enable_if<detail::is_iterator<Iter>::value>::type>
 	fixed_map(Iter begin_, Iter end_) {
@@ -131,29 +158,118 @@ protected:
 
 	static inline std::size_t hash(const key_type& key) { return Hash{}(key); }
 
-	static inline size_type hash_to_index(const key_type& key) { return static_cast<size_type>(hash(key) % max_size()); }
+	static inline size_type index_of(std::size_t h) { return static_cast<size_type>(h % max_size()); }
 
-	inline size_type find_index(const key_type& key) const {
-		auto start_index = hash_to_index(key);
-		auto index = start_index;
-		do {
-			const auto& slot = data_[index];
-			if (slot.valid && slot.key == key) {
-				return index;
+	static inline size_type hash_to_index(const key_type& key) { return index_of(hash(key)); }
+
+	// The top bits of the mixed (Fibonacci hashing) hash, so keys sharing a home slot rarely match
+	// even when the hash is the identity and h / max_size() would be 0 for every small key
+	static inline std::uint8_t fingerprint_of(std::size_t h) {
+		return static_cast<std::uint8_t>((static_cast<std::uint64_t>(h) * 0x9e3779b97f4a7c15ull) >> 56);
+	}
+
+	static inline size_type next_index(size_type index) { return index + 1 == max_size() ? 0 : index + 1; }
+
+	// Number of probe steps from index from to index to
+	static inline size_type distance(size_type from, size_type to) { return to >= from ? to - from : to + max_size() - from; }
+
+	// Returns the slot the new element was placed in, requires size_ < max_size()
+	template<typename Key_> size_type insert_new(const Key_& key, const T& value, std::size_t h, std::false_type) {
+		size_type index = index_of(h);
+		while (data_[index].valid) index = next_index(index);
+		data_[index].key = key;
+		data_[index].value = value;
+		data_[index].valid = true;
+		data_[index].fingerprint = fingerprint_of(h);
+		return index;
+	}
+
+	template<typename Key_> size_type insert_new(const Key_& key, const T& value, std::size_t h, std::true_type) {
+		value_type carried;
+		carried.key = key;
+		carried.value = value;
+		carried.valid = true;
+		carried.fingerprint = fingerprint_of(h);
+		size_type inserted = -1;
+		for (size_type index = index_of(h);; index = next_index(index), carried.probe_distance++) {
+			value_type& slot = data_[index];
+			if (!slot.valid) {
+				slot = std::move(carried);
+				return inserted == -1 ? index : inserted;
 			}
-			index = (index + 1) % max_size();
+			// Take from the rich: the displaced element continues the walk
+			if (slot.probe_distance < carried.probe_distance) {
+				std::swap(slot, carried);
+				if (inserted == -1) inserted = index;
+			}
+		}
+	}
+
+	void erase_at(size_type hole, std::false_type) {
+		size_type index = next_index(hole);
+		// A full map has no empty slot to stop at, so look at most at every other slot once
+		for (size_type steps = 1; steps < max_size() && data_[index].valid; ++steps) {
+			// An element can fill the hole unless its home slot lies cyclically in (hole, index]
+			const size_type home = hash_to_index(data_[index].key);
+			if (distance(home, index) >= distance(hole, index)) {
+				data_[hole] = std::move(data_[index]);
+				hole = index;
+			}
+			index = next_index(index);
+		}
+		data_[hole] = value_type();
+	}
+
+	// Probe runs are sorted by distance, so every following element not in its home slot moves back one
+	void erase_at(size_type hole, std::true_type) {
+		size_type index = next_index(hole);
+		for (size_type steps = 1; steps < max_size() && data_[index].valid && data_[index].probe_distance > 0; ++steps) {
+			data_[hole] = std::move(data_[index]);
+			data_[hole].probe_distance--;
+			hole = index;
+			index = next_index(index);
+		}
+		data_[hole] = value_type();
+	}
+
+	inline size_type find_index(const key_type& key) const { return find_index(key, is_robin_hood()); }
+
+	// Elements are never separated from their home slot by an empty slot (erase shifts the
+	// probe run back instead of leaving tombstones), so a miss ends at the first empty slot
+	inline size_type find_index(const key_type& key, std::false_type) const {
+		const std::size_t h = hash(key);
+		const std::uint8_t fingerprint = fingerprint_of(h);
+		size_type index = index_of(h);
+		for (size_type steps = 0; steps < max_size(); ++steps) {
+			const auto& slot = data_[index];
+			if (!slot.valid) return -1;
+			if (slot.fingerprint == fingerprint && slot.key == key) return index;
+			index = next_index(index);
 		}
-		while (index != start_index);
 		return -1;
 	}
 
-	template<typename Key_, typename T_, int Capacity_, class Hash_>
-	friend std::ostream& operator<<(std::ostream&, const fixed_map<Key_, T_, Capacity_, Hash_>&);
+	// The key would have been placed before any element closer to its home than the key is
+	inline size_type find_index(const key_type& key, std::true_type) const {
+		const std::size_t h = hash(key);
+		const std::uint8_t fingerprint = fingerprint_of(h);
+		size_type index = index_of(h);
+		for (size_type probe = 0; probe < max_size(); ++probe) {
+			const auto& slot = data_[index];
+			if (!slot.valid || slot.probe_distance < probe) return -1;
+			if (slot.fingerprint == fingerprint && slot.key == key) return index;
+			index = next_index(index);
+		}
+		return -1;
+	}
+
+	template<typename Key_, typename T_, int Capacity_, class Hash_, probing Probing_>
+	friend std::ostream& operator<<(std::ostream&, const fixed_map<Key_, T_, Capacity_, Hash_, Probing_>&);
 };
 
-template<typename Key_, typename T_, int Capacity_, class Hash_>
+template<typename Key_, typename T_, int Capacity_, class Hash_, probing Probing_>
 inline std::ostream& operator<<(std::ostream& out,
-								const fixed_map<Key_, T_, Capacity_, Hash_>& map) {
+								const fixed_map<Key_, T_, Capacity_, Hash_, Probing_>& map) {
 	out << "fixed_map<" << Capacity_ << "> {";
 	if (map.empty())
 		out << "}";
@@ -172,6 +288,9 @@ inline std::ostream& operator<<(std::ostream& out,
 	return out;
 }
 
+template<typename Key, typename T, int Capacity, class Hash, probing Probing>
+const probing fixed_map<Key, T, Capacity, Hash, Probing>::probing_mode;
+
 } // namespace bsp
 
 #endif
\ No newline at end of file
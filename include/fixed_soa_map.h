@@ -0,0 +1,277 @@
+// A fixed capacity hashmap with the same interface and probing as fixed_map (linear probing,
+// misses stop at the first empty slot, backward-shift erase), stored as a structure of arrays:
+// keys, values and a bitmap of the occupied slots. There is no per-slot padding, so
+// fixed_soa_map<std::uint32_t, std::uint32_t, N> takes 8 bytes and 1 bit per slot, probing
+// only reads the bitmap and the keys, and iteration jumps between occupied slots a bitmap word
+// at a time. Unlike fixed_map it keeps no hash fingerprints, so prefer it for keys that are
+// cheap to compare.
+
+#ifndef BSP_FIXED_SOA_MAP_H
+#define BSP_FIXED_SOA_MAP_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace bsp {
+
+namespace detail_fixed_soa_map {
+
+inline int count_trailing_zeros(std::uint64_t word) {
+	assert(word != 0);
+#if defined(__GNUC__)
+	return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index = 0;
+	_BitScanForward64(&index, word);
+	return static_cast<int>(index);
+#else
+	int index = 0;
+	while ((word & 1) == 0) {
+		word >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+} // namespace detail_fixed_soa_map
+
+template<typename Key, typename T, int Capacity, class Hash = std::hash<Key>> class fixed_soa_map {
+	static_assert(Capacity > 0, "Capacity <= 0!");
+
+protected:
+	static const int num_words = (Capacity + 63) / 64;
+
+	template<bool Const> class basic_iterator;
+
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = int;
+
+	// What iterators point at, the key and value of an element are stored apart
+	struct element {
+		const Key& key;
+		T& value;
+	};
+	struct const_element {
+		const Key& key;
+		const T& value;
+	};
+
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+
+public:
+	fixed_soa_map(const T& invalid_value = T()) : invalid_value_(invalid_value) { clear(); }
+
+	template<class Container> fixed_soa_map(const Container& els) : fixed_soa_map(els.begin(), els.end()) {}
+
+	fixed_soa_map(std::initializer_list<std::pair<Key, T>> list) : fixed_soa_map(list.begin(), list.end()) {}
+
+	void clear() {
+		size_ = 0;
+		valid_.fill(0);
+		keys_.fill(Key());
+		values_.fill(T());
+	}
+
+	bool empty() const { return size_ == 0; }
+
+	size_type size() const { return size_; }
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	bool has(const key_type& key) const { return find_index(key) != -1; }
+
+	const_reference find(const key_type& key) const {
+		const size_type index = find_index(key);
+		return index != -1 ? values_[index] : invalid_value_;
+	}
+
+	reference find(const key_type& key) {
+		const size_type index = find_index(key);
+		return index != -1 ? values_[index] : invalid_value_;
+	}
+
+	reference operator[](const key_type& key) { return find(key); }
+
+	const_reference operator[](const key_type& key) const { return find(key); }
+
+	// Like fixed_map::insert, doesn't check whether the key is already present
+	template<typename Key_> iterator insert(const Key_& key, const T& value) {
+		if (size_ >= max_size()) {
+			throw std::length_error("fixed_soa_map: trying to insert too many elements");
+		}
+		size_type index = hash_to_index(key);
+		while (is_valid(index)) index = next_index(index);
+		keys_[index] = key;
+		values_[index] = value;
+		set_valid(index);
+		size_++;
+		return iterator(this, index);
+	}
+
+	// Removes the element with key, returns the number of elements removed (0 or 1)
+	// Backward-shift deletion, as in fixed_map::erase
+	size_type erase(const key_type& key) {
+		size_type hole = find_index(key);
+		if (hole == -1) return 0;
+		size_type index = next_index(hole);
+		for (size_type steps = 1; steps < max_size() && is_valid(index); ++steps) {
+			const size_type home = hash_to_index(keys_[index]);
+			if (distance(home, index) >= distance(hole, index)) {
+				keys_[hole] = std::move(keys_[index]);
+				values_[hole] = std::move(values_[index]);
+				hole = index;
+			}
+			index = next_index(index);
+		}
+		keys_[hole] = Key();
+		values_[hole] = T();
+		clear_valid(hole);
+		size_--;
+		return 1;
+	}
+
+	iterator begin() { return iterator(this, next_valid(0)); }
+	iterator end() { return iterator(this, max_size()); }
+
+	const_iterator begin() const { return const_iterator(this, next_valid(0)); }
+	const_iterator end() const { return const_iterator(this, max_size()); }
+
+protected:
+	std::array<Key, Capacity> keys_;
+	std::array<T, Capacity> values_;
+	std::array<std::uint64_t, num_words> valid_; // Bit i % 64 of word i / 64 is set if slot i is occupied
+	size_type size_ = 0;
+	T invalid_value_;
+
+protected:
+	template<typename Iter> fixed_soa_map(Iter begin_, Iter end_) : fixed_soa_map() {
+		const auto size = static_cast<size_type>(std::distance(begin_, end_));
+		if (size > max_size()) throw std::length_error("fixed_soa_map: too many elements");
+		for (auto it = begin_; it != end_; ++it) insert(it->first, it->second);
+	}
+
+	static inline size_type hash_to_index(const key_type& key) { return static_cast<size_type>(Hash {}(key) % max_size()); }
+
+	static inline size_type next_index(size_type index) { return index + 1 == max_size() ? 0 : index + 1; }
+
+	// Number of probe steps from index from to index to
+	static inline size_type distance(size_type from, size_type to) { return to >= from ? to - from : to + max_size() - from; }
+
+	bool is_valid(size_type index) const { return (valid_[index / 64] >> (index % 64)) & 1; }
+	void set_valid(size_type index) { valid_[index / 64] |= std::uint64_t(1) << (index % 64); }
+	void clear_valid(size_type index) { valid_[index / 64] &= ~(std::uint64_t(1) << (index % 64)); }
+
+	size_type find_index(const key_type& key) const {
+		size_type index = hash_to_index(key);
+		for (size_type steps = 0; steps < max_size(); ++steps) {
+			if (!is_valid(index)) return -1;
+			if (keys_[index] == key) return index;
+			index = next_index(index);
+		}
+		return -1;
+	}
+
+	// The first occupied slot at or after index, or max_size()
+	size_type next_valid(size_type index) const {
+		if (index >= max_size()) return max_size();
+		size_type w = index / 64;
+		std::uint64_t word = valid_[w] & (~std::uint64_t(0) << (index % 64));
+		while (word == 0) {
+			if (++w == num_words) return max_size();
+			word = valid_[w];
+		}
+		return w * 64 + detail_fixed_soa_map::count_trailing_zeros(word);
+	}
+
+	template<bool Const> class basic_iterator {
+	public:
+		using map_type = typename std::conditional<Const, const fixed_soa_map, fixed_soa_map>::type;
+		using value_type = typename std::conditional<Const, const_element, element>::type;
+		using reference = value_type;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+
+		// Lets it->key work although elements are built on the fly
+		struct pointer {
+			value_type element;
+			const value_type* operator->() const { return &element; }
+		};
+
+		basic_iterator() = default;
+		basic_iterator(map_type* map, size_type index) : map_(map), index_(index) {
+			if (index_ < max_size()) bits_ = map_->valid_[index_ / 64] & (~std::uint64_t(1) << (index_ % 64));
+		}
+		// iterator converts to const_iterator
+		template<bool Const_, typename = typename std::enable_if<Const && !Const_>::type>
+		basic_iterator(const basic_iterator<Const_>& other) : map_(other.map_), index_(other.index_), bits_(other.bits_) {}
+
+		reference operator*() const { return reference { map_->keys_[index_], map_->values_[index_] }; }
+		pointer operator->() const { return pointer { **this }; }
+
+		basic_iterator& operator++() {
+			if (bits_ != 0) {
+				index_ = (index_ & ~63) + detail_fixed_soa_map::count_trailing_zeros(bits_);
+				bits_ &= bits_ - 1;
+			}
+			else {
+				index_ = map_->next_valid((index_ & ~63) + 64);
+				if (index_ < max_size()) bits_ = map_->valid_[index_ / 64] & (~std::uint64_t(1) << (index_ % 64));
+			}
+			return *this;
+		}
+
+		basic_iterator operator++(int) {
+			basic_iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const basic_iterator& other) const { return index_ == other.index_; }
+		bool operator!=(const basic_iterator& other) const { return index_ != other.index_; }
+
+	protected:
+		map_type* map_ = nullptr;
+		size_type index_ = 0;
+		std::uint64_t bits_ = 0; // The occupied slots after index_ in its bitmap word
+
+		friend class fixed_soa_map;
+		template<bool> friend class basic_iterator;
+	};
+};
+
+template<typename Key, typename T, int Capacity, class Hash> const int fixed_soa_map<Key, T, Capacity, Hash>::num_words;
+
+template<typename Key_, typename T_, int Capacity_, class Hash_>
+std::ostream& operator<<(std::ostream& out, const fixed_soa_map<Key_, T_, Capacity_, Hash_>& map) {
+	out << "fixed_soa_map<" << Capacity_ << "> {";
+	bool first = true;
+	for (auto it = map.begin(); it != map.end(); ++it) {
+		if (!first) out << ", ";
+		out << it->key << ": " << it->value;
+		first = false;
+	}
+	return out << "}";
+}
+
+} // namespace bsp
+
+#endif
@@ -0,0 +1,369 @@
+// A fixed capacity hashmap with the same interface as fixed_map, laid out like a Swiss table.
+// Metadata lives in its own array of control bytes, one per slot: empty, deleted (a tombstone)
+// or full, with 7 bits of the key's hash as a tag. Slots are probed in groups of 16, and a
+// lookup compares the tag against a whole group of control bytes at once (SSE2), only touching
+// the key array where a tag matches. Keys and values are stored in two more arrays, so probing
+// never loads values and nothing is lost to padding.
+// Erase leaves a tombstone unless the slot's group still has an empty slot, inserts reuse them.
+// Once tombstones outnumber the empty slots, erase turns them all back into empty slots and
+// reinserts the elements in place, so churn can't leave misses probing every group.
+// Customise the behaviour by defining these before including it:
+// #define BSP_FIXED_SWISS_MAP_SCALAR to always use the scalar group matching
+
+#ifndef BSP_FIXED_SWISS_MAP_H
+#define BSP_FIXED_SWISS_MAP_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+#if !defined(BSP_FIXED_SWISS_MAP_SCALAR)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BSP_FIXED_SWISS_MAP_SSE2 1
+#include <emmintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace bsp {
+
+namespace detail_fixed_swiss_map {
+
+const int group_size = 16;
+
+// Control bytes, a full slot holds its 7-bit tag in [0, 127]
+const std::int8_t empty = -128;
+const std::int8_t deleted = -2;
+
+inline int count_trailing_zeros(std::uint32_t word) {
+	assert(word != 0);
+#if defined(__GNUC__)
+	return __builtin_ctz(word);
+#elif defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward(&index, word);
+	return static_cast<int>(index);
+#else
+	int index = 0;
+	while ((word & 1) == 0) {
+		word >>= 1;
+		++index;
+	}
+	return index;
+#endif
+}
+
+// Bit i is set for every control byte i of the group equal to value
+inline std::uint32_t match(const std::int8_t* group, std::int8_t value) {
+#if defined(BSP_FIXED_SWISS_MAP_SSE2)
+	const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+	return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+	std::uint32_t mask = 0;
+	for (int i = 0; i < group_size; ++i) mask |= std::uint32_t(group[i] == value) << i;
+	return mask;
+#endif
+}
+
+// Bit i is set for every empty or deleted control byte i of the group
+inline std::uint32_t match_free(const std::int8_t* group) {
+#if defined(BSP_FIXED_SWISS_MAP_SSE2)
+	const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+	return static_cast<std::uint32_t>(_mm_movemask_epi8(bytes));
+#else
+	std::uint32_t mask = 0;
+	for (int i = 0; i < group_size; ++i) mask |= std::uint32_t(group[i] < 0) << i;
+	return mask;
+#endif
+}
+
+} // namespace detail_fixed_swiss_map
+
+template<typename Key, typename T, int Capacity, class Hash = std::hash<Key>> class fixed_swiss_map {
+	static_assert(Capacity > 0, "Capacity <= 0!");
+
+protected:
+	static const int group_size = detail_fixed_swiss_map::group_size;
+	static const int num_groups = (Capacity + group_size - 1) / group_size;
+	static const int num_slots = num_groups * group_size;
+
+	template<bool Const> class basic_iterator;
+
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = int;
+
+	// What iterators point at, the key and value of an element are stored apart
+	struct element {
+		const Key& key;
+		T& value;
+	};
+	struct const_element {
+		const Key& key;
+		const T& value;
+	};
+
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+
+public:
+	fixed_swiss_map(const T& invalid_value = T()) : invalid_value_(invalid_value) { clear(); }
+
+	template<class Container> fixed_swiss_map(const Container& els) : fixed_swiss_map(els.begin(), els.end()) {}
+
+	fixed_swiss_map(std::initializer_list<std::pair<Key, T>> list) : fixed_swiss_map(list.begin(), list.end()) {}
+
+	void clear() {
+		size_ = 0;
+		tombstones_ = 0;
+		ctrl_.fill(detail_fixed_swiss_map::empty);
+		keys_.fill(Key());
+		values_.fill(T());
+	}
+
+	bool empty() const { return size_ == 0; }
+
+	size_type size() const { return size_; }
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	bool has(const key_type& key) const { return find_index(key) != -1; }
+
+	const_reference find(const key_type& key) const {
+		const size_type index = find_index(key);
+		return index != -1 ? values_[index] : invalid_value_;
+	}
+
+	reference find(const key_type& key) {
+		const size_type index = find_index(key);
+		return index != -1 ? values_[index] : invalid_value_;
+	}
+
+	reference operator[](const key_type& key) { return find(key); }
+
+	const_reference operator[](const key_type& key) const { return find(key); }
+
+	// Like fixed_map::insert, doesn't check whether the key is already present
+	template<typename Key_> iterator insert(const Key_& key, const T& value) {
+		if (size_ >= max_size()) {
+			throw std::length_error("fixed_swiss_map: trying to insert too many elements");
+		}
+		const std::size_t h = mix(hash(key));
+		// max_size() <= num_slots, so some group has a free slot
+		const size_type index = first_free(h);
+		if (ctrl_[index] == detail_fixed_swiss_map::deleted) tombstones_--;
+		ctrl_[index] = tag_of(h);
+		keys_[index] = key;
+		values_[index] = value;
+		size_++;
+		return iterator(this, index);
+	}
+
+	// Removes the element with key, returns the number of elements removed (0 or 1)
+	size_type erase(const key_type& key) {
+		const size_type index = find_index(key);
+		if (index == -1) return 0;
+		// Lookups only move on from a group without empty slots, so if this group already has one,
+		// emptying the slot can't cut another key's probe sequence short
+		if (detail_fixed_swiss_map::match(group_ctrl(index / group_size), detail_fixed_swiss_map::empty) != 0) {
+			ctrl_[index] = detail_fixed_swiss_map::empty;
+		}
+		else {
+			ctrl_[index] = detail_fixed_swiss_map::deleted;
+			tombstones_++;
+		}
+		keys_[index] = Key();
+		values_[index] = T();
+		size_--;
+		if (size_ == 0) {
+			ctrl_.fill(detail_fixed_swiss_map::empty);
+			tombstones_ = 0;
+		}
+		else if (tombstones_ > num_slots - size_ - tombstones_) drop_tombstones();
+		return 1;
+	}
+
+	iterator begin() { return iterator(this, first_full(0)); }
+	iterator end() { return iterator(this, num_slots); }
+
+	const_iterator begin() const { return const_iterator(this, first_full(0)); }
+	const_iterator end() const { return const_iterator(this, num_slots); }
+
+protected:
+	std::array<std::int8_t, num_slots> ctrl_;
+	std::array<Key, num_slots> keys_;
+	std::array<T, num_slots> values_;
+	size_type size_ = 0;
+	size_type tombstones_ = 0; // Number of deleted control bytes
+	T invalid_value_;
+
+protected:
+	template<typename Iter> fixed_swiss_map(Iter begin_, Iter end_) : fixed_swiss_map() {
+		const auto size = static_cast<size_type>(std::distance(begin_, end_));
+		if (size > max_size()) throw std::length_error("fixed_swiss_map: too many elements");
+		for (auto it = begin_; it != end_; ++it) insert(it->first, it->second);
+	}
+
+	static inline std::size_t hash(const key_type& key) { return Hash {}(key); }
+
+	// The tag and the group come from different bits of the hash, so mix it first in case
+	// it is weak (std::hash of an integer is usually the identity)
+	static inline std::size_t mix(std::size_t h) { return h * static_cast<std::size_t>(0x9e3779b97f4a7c15ull); }
+
+	// The top 7 bits
+	static inline std::int8_t tag_of(std::size_t h) {
+		return static_cast<std::int8_t>(h >> (sizeof(std::size_t) * 8 - 7));
+	}
+
+	static inline size_type group_of(std::size_t h) { return static_cast<size_type>((h >> 7) % num_groups); }
+
+	static inline size_type next_group(size_type group) { return group + 1 == num_groups ? 0 : group + 1; }
+
+	const std::int8_t* group_ctrl(size_type group) const { return ctrl_.data() + group * group_size; }
+
+	// Checks a group at a time: every slot with a matching tag, then stops if the group has an empty slot
+	size_type find_index(const key_type& key) const {
+		const std::size_t h = mix(hash(key));
+		const std::int8_t tag = tag_of(h);
+		size_type group = group_of(h);
+		for (size_type probes = 0; probes < num_groups; ++probes) {
+			const std::int8_t* ctrl = group_ctrl(group);
+			for (std::uint32_t matches = detail_fixed_swiss_map::match(ctrl, tag); matches != 0; matches &= matches - 1) {
+				const size_type index = group * group_size + detail_fixed_swiss_map::count_trailing_zeros(matches);
+				if (keys_[index] == key) return index;
+			}
+			if (detail_fixed_swiss_map::match(ctrl, detail_fixed_swiss_map::empty) != 0) return -1;
+			group = next_group(group);
+		}
+		return -1;
+	}
+
+	// The first empty or deleted slot on h's probe sequence, requires one to exist
+	size_type first_free(std::size_t h) const {
+		size_type group = group_of(h);
+		std::uint32_t free = detail_fixed_swiss_map::match_free(group_ctrl(group));
+		while (free == 0) {
+			group = next_group(group);
+			free = detail_fixed_swiss_map::match_free(group_ctrl(group));
+		}
+		return group * group_size + detail_fixed_swiss_map::count_trailing_zeros(free);
+	}
+
+	// Rehashes in place without tombstones: tombstones become empty and full slots are marked
+	// deleted, then each marked element stays put if its probe sequence reaches its own group
+	// first, moves if it reaches an empty slot first, or swaps with the marked element it reaches,
+	// which is placed next. Groups that are full stay full throughout, so no probe run is cut short.
+	void drop_tombstones() {
+		using detail_fixed_swiss_map::deleted;
+		using detail_fixed_swiss_map::empty;
+		for (auto& ctrl : ctrl_) ctrl = ctrl < 0 ? empty : deleted;
+		for (size_type index = 0; index < num_slots; ++index) {
+			if (ctrl_[index] != deleted) continue;
+			const std::size_t h = mix(hash(keys_[index]));
+			const size_type target = first_free(h);
+			if (target / group_size == index / group_size) {
+				ctrl_[index] = tag_of(h);
+			}
+			else if (ctrl_[target] == empty) {
+				ctrl_[target] = tag_of(h);
+				ctrl_[index] = empty;
+				keys_[target] = std::move(keys_[index]);
+				values_[target] = std::move(values_[index]);
+				keys_[index] = Key();
+				values_[index] = T();
+			}
+			else {
+				ctrl_[target] = tag_of(h);
+				std::swap(keys_[index], keys_[target]);
+				std::swap(values_[index], values_[target]);
+				--index; // Place the element swapped into index next
+			}
+		}
+		tombstones_ = 0;
+	}
+
+	// The first full slot at or after index, or num_slots
+	size_type first_full(size_type index) const {
+		while (index < num_slots && ctrl_[index] < 0) ++index;
+		return index;
+	}
+
+	template<bool Const> class basic_iterator {
+	public:
+		using map_type = typename std::conditional<Const, const fixed_swiss_map, fixed_swiss_map>::type;
+		using value_type = typename std::conditional<Const, const_element, element>::type;
+		using reference = value_type;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+
+		// Lets it->key work although elements are built on the fly
+		struct pointer {
+			value_type element;
+			const value_type* operator->() const { return &element; }
+		};
+
+		basic_iterator() = default;
+		basic_iterator(map_type* map, size_type index) : map_(map), index_(index) {}
+		// iterator converts to const_iterator
+		template<bool Const_, typename = typename std::enable_if<Const && !Const_>::type>
+		basic_iterator(const basic_iterator<Const_>& other) : map_(other.map_), index_(other.index_) {}
+
+		reference operator*() const { return reference { map_->keys_[index_], map_->values_[index_] }; }
+		pointer operator->() const { return pointer { **this }; }
+
+		basic_iterator& operator++() {
+			index_ = map_->first_full(index_ + 1);
+			return *this;
+		}
+
+		basic_iterator operator++(int) {
+			basic_iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const basic_iterator& other) const { return index_ == other.index_; }
+		bool operator!=(const basic_iterator& other) const { return index_ != other.index_; }
+
+	protected:
+		map_type* map_ = nullptr;
+		size_type index_ = 0;
+
+		friend class fixed_swiss_map;
+		template<bool> friend class basic_iterator;
+	};
+};
+
+template<typename Key, typename T, int Capacity, class Hash> const int fixed_swiss_map<Key, T, Capacity, Hash>::group_size;
+template<typename Key, typename T, int Capacity, class Hash> const int fixed_swiss_map<Key, T, Capacity, Hash>::num_groups;
+template<typename Key, typename T, int Capacity, class Hash> const int fixed_swiss_map<Key, T, Capacity, Hash>::num_slots;
+
+template<typename Key_, typename T_, int Capacity_, class Hash_>
+std::ostream& operator<<(std::ostream& out, const fixed_swiss_map<Key_, T_, Capacity_, Hash_>& map) {
+	out << "fixed_swiss_map<" << Capacity_ << "> {";
+	bool first = true;
+	for (auto it = map.begin(); it != map.end(); ++it) {
+		if (!first) out << ", ";
+		out << it->key << ": " << it->value;
+		first = false;
+	}
+	return out << "}";
+}
+
+} // namespace bsp
+
+#endif
@@ -0,0 +1,290 @@
+// A growable hashmap with fixed_map's probing and interface, stored in one heap array of slots.
+// Like fixed_map it uses open addressing with linear probing, 8-bit hash fingerprints per slot,
+// misses that stop at the first empty slot and backward-shift erase (no tombstones). Instead of
+// throwing when full it doubles: the number of slots is always a power of two, and the map
+// rehashes into a new array whenever an insert would go over max_load_factor().
+// Use reserve() to size it up front. Differences from std::unordered_map:
+// - find() and operator[] return the invalid value for a missing key, they never insert
+// - iterators visit every slot (check slot.valid, as with fixed_map), and rehashing or erasing
+//   invalidates them
+// - elements move when the map rehashes or erases, so references to them don't stay valid
+// The hash is mixed (Fibonacci hashing) before use, so std::hash of an integer, usually the
+// identity, is fine.
+
+#ifndef BSP_FLAT_HASH_MAP_H
+#define BSP_FLAT_HASH_MAP_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bsp {
+
+template<typename Key, typename T, class Hash = std::hash<Key>> class flat_hash_map {
+public:
+	struct slot {
+		Key key;
+		T value;
+		bool valid = false;
+		std::uint8_t fingerprint = 0;
+	};
+
+	using slots_type = std::vector<slot>;
+
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = slot;
+	using reference = T&;
+	using const_reference = const T&;
+	using iterator = typename slots_type::iterator;
+	using const_iterator = typename slots_type::const_iterator;
+	using size_type = std::size_t;
+
+public:
+	flat_hash_map(const T& invalid_value = T()) : invalid_value_(invalid_value) {}
+
+	template<class Container> flat_hash_map(const Container& els) : flat_hash_map(els.begin(), els.end()) {}
+
+	flat_hash_map(std::initializer_list<std::pair<Key, T>> list) : flat_hash_map(list.begin(), list.end()) {}
+
+	flat_hash_map(const flat_hash_map&) = default;
+	flat_hash_map& operator=(const flat_hash_map&) = default;
+
+	// Takes other's slots and leaves it empty without any, as if default constructed
+	flat_hash_map(flat_hash_map&& other)
+		: slots_(std::move(other.slots_)), size_(other.size_), shift_(other.shift_), max_load_factor_(other.max_load_factor_),
+		  invalid_value_(other.invalid_value_) {
+		other.release();
+	}
+
+	flat_hash_map& operator=(flat_hash_map&& other) {
+		if (this == &other) return *this;
+		slots_ = std::move(other.slots_);
+		size_ = other.size_;
+		shift_ = other.shift_;
+		max_load_factor_ = other.max_load_factor_;
+		invalid_value_ = other.invalid_value_;
+		other.release();
+		return *this;
+	}
+
+	// Removes every element, keeps the slots
+	void clear() {
+		size_ = 0;
+		std::fill(slots_.begin(), slots_.end(), value_type());
+	}
+
+	bool empty() const { return size_ == 0; }
+
+	size_type size() const { return size_; }
+
+	// Number of slots, 0 or a power of two
+	size_type bucket_count() const { return slots_.size(); }
+
+	float load_factor() const { return slots_.empty() ? 0.0f : static_cast<float>(size_) / slots_.size(); }
+
+	float max_load_factor() const { return max_load_factor_; }
+
+	// Requires 0 < ml < 1, rehashes if the map is now over it
+	void max_load_factor(float ml) {
+		if (!(ml > 0.0f && ml < 1.0f)) throw std::invalid_argument("flat_hash_map: max load factor must be in (0, 1)");
+		max_load_factor_ = ml;
+		reserve(size_);
+	}
+
+	// Makes room for count elements without going over max_load_factor(), never shrinks
+	void reserve(size_type count) {
+		if (!fits(count)) rehash(slots_for(count));
+	}
+
+	// Resizes to at least count slots (a power of two) and at least enough for size(), can shrink
+	void rehash(size_type count) {
+		count = std::max(count, slots_for(size_));
+		const size_type new_count = count == 0 ? 0 : round_up_to_power_of_two(std::max(count, min_bucket_count));
+		if (new_count != slots_.size()) rehash_to(new_count);
+	}
+
+	bool has(const key_type& key) const { return find_index(key) != npos; }
+
+	const_reference find(const key_type& key) const {
+		const size_type index = find_index(key);
+		return index != npos ? slots_[index].value : invalid_value_;
+	}
+
+	reference find(const key_type& key) {
+		const size_type index = find_index(key);
+		return index != npos ? slots_[index].value : invalid_value_;
+	}
+
+	reference operator[](const key_type& key) { return find(key); }
+
+	const_reference operator[](const key_type& key) const { return find(key); }
+
+	// Inserts the element unless key is already present, returns the element with key
+	// Unlike fixed_map::insert, looks for key in the same pass that finds the free slot, and only
+	// grows once it knows key is missing, so inserting a present key never rehashes
+	template<typename Key_> iterator insert(const Key_& key_, const T& value) {
+		key_type key(key_);
+		const std::uint64_t h = mix(hash(key));
+		if (!slots_.empty()) {
+			const std::uint8_t fingerprint = fingerprint_of(h);
+			size_type index = index_of(h);
+			while (slots_[index].valid) {
+				if (slots_[index].fingerprint == fingerprint && slots_[index].key == key) return begin() + index;
+				index = next_index(index);
+			}
+			if (fits(size_ + 1)) return place(index, std::move(key), value, fingerprint);
+		}
+		// The home slot and fingerprint depend on the number of slots, so probe again after growing
+		// reserve rather than a single doubling, which can stay over a small max_load_factor()
+		reserve(size_ + 1);
+		size_type index = index_of(h);
+		while (slots_[index].valid) index = next_index(index);
+		return place(index, std::move(key), value, fingerprint_of(h));
+	}
+
+	// Removes the element with key, returns the number of elements removed (0 or 1)
+	// Backward-shift deletion, as in fixed_map::erase
+	size_type erase(const key_type& key) {
+		size_type hole = find_index(key);
+		if (hole == npos) return 0;
+		// The load factor is below 1, so the run ends at an empty slot
+		for (size_type index = next_index(hole); slots_[index].valid; index = next_index(index)) {
+			// An element can fill the hole unless its home slot lies cyclically in (hole, index]
+			const size_type home = index_of(mix(hash(slots_[index].key)));
+			if (distance(home, index) >= distance(hole, index)) {
+				slots_[hole] = std::move(slots_[index]);
+				hole = index;
+			}
+		}
+		slots_[hole] = value_type();
+		size_--;
+		return 1;
+	}
+
+	iterator begin() { return slots_.begin(); }
+	iterator end() { return slots_.end(); }
+
+	const_iterator begin() const { return slots_.begin(); }
+	const_iterator end() const { return slots_.end(); }
+
+protected:
+	static const size_type npos = static_cast<size_type>(-1);
+	static const size_type min_bucket_count = 8;
+
+	slots_type slots_;
+	size_type size_ = 0;
+	int shift_ = 64; // 64 - log2(bucket_count()), the index is the top bits of the mixed hash
+	float max_load_factor_ = 0.75f;
+	T invalid_value_;
+
+protected:
+	template<typename Iter> flat_hash_map(Iter begin_, Iter end_) : flat_hash_map() {
+		reserve(static_cast<size_type>(std::distance(begin_, end_)));
+		for (auto it = begin_; it != end_; ++it) insert(it->first, it->second);
+	}
+
+	static inline std::size_t hash(const key_type& key) { return Hash {}(key); }
+
+	static inline std::uint64_t mix(std::size_t h) { return static_cast<std::uint64_t>(h) * 0x9e3779b97f4a7c15ull; }
+
+	// Requires bucket_count() > 0
+	inline size_type index_of(std::uint64_t h) const { return static_cast<size_type>(h >> shift_); }
+
+	// The 8 bits below the index bits, so keys sharing a home slot rarely match
+	inline std::uint8_t fingerprint_of(std::uint64_t h) const {
+		return static_cast<std::uint8_t>(shift_ >= 8 ? h >> (shift_ - 8) : h);
+	}
+
+	inline size_type next_index(size_type index) const { return (index + 1) & (slots_.size() - 1); }
+
+	// Number of probe steps from index from to index to
+	inline size_type distance(size_type from, size_type to) const { return (to - from) & (slots_.size() - 1); }
+
+	static size_type round_up_to_power_of_two(size_type n) {
+		size_type p = 1;
+		while (p < n) p <<= 1;
+		return p;
+	}
+
+	bool fits(size_type count) const { return static_cast<double>(count) <= static_cast<double>(max_load_factor_) * slots_.size(); }
+
+	size_type slots_for(size_type count) const {
+		return static_cast<size_type>(std::ceil(static_cast<double>(count) / static_cast<double>(max_load_factor_)));
+	}
+
+	// Drops the slots, keeps max_load_factor() and the invalid value
+	void release() {
+		slots_.clear();
+		size_ = 0;
+		shift_ = 64;
+	}
+
+	// Fills the empty slot at index
+	iterator place(size_type index, key_type&& key, const T& value, std::uint8_t fingerprint) {
+		slot& s = slots_[index];
+		s.key = std::move(key);
+		s.value = value;
+		s.valid = true;
+		s.fingerprint = fingerprint;
+		size_++;
+		return begin() + index;
+	}
+
+	// Moves every element into a new array of count slots, the index and fingerprint bits
+	// depend on the number of slots so both are recomputed
+	void rehash_to(size_type count) {
+		slots_type old(count);
+		old.swap(slots_);
+		shift_ = 64;
+		for (size_type n = count; n > 1; n >>= 1) shift_--;
+		for (slot& s : old) {
+			if (!s.valid) continue;
+			const std::uint64_t h = mix(hash(s.key));
+			size_type index = index_of(h);
+			while (slots_[index].valid) index = next_index(index);
+			slots_[index] = std::move(s);
+			slots_[index].fingerprint = fingerprint_of(h);
+		}
+	}
+
+	inline size_type find_index(const key_type& key) const {
+		if (size_ == 0) return npos;
+		const std::uint64_t h = mix(hash(key));
+		const std::uint8_t fingerprint = fingerprint_of(h);
+		for (size_type index = index_of(h);; index = next_index(index)) {
+			const slot& s = slots_[index];
+			if (!s.valid) return npos;
+			if (s.fingerprint == fingerprint && s.key == key) return index;
+		}
+	}
+};
+
+template<typename Key, typename T, class Hash> const typename flat_hash_map<Key, T, Hash>::size_type flat_hash_map<Key, T, Hash>::npos;
+template<typename Key, typename T, class Hash> const typename flat_hash_map<Key, T, Hash>::size_type flat_hash_map<Key, T, Hash>::min_bucket_count;
+
+template<typename Key_, typename T_, class Hash_>
+std::ostream& operator<<(std::ostream& out, const flat_hash_map<Key_, T_, Hash_>& map) {
+	out << "flat_hash_map {";
+	bool first = true;
+	for (const auto& slot : map) {
+		if (!slot.valid) continue;
+		if (!first) out << ", ";
+		out << slot.key << ": " << slot.value;
+		first = false;
+	}
+	return out << "}";
+}
+
+} // namespace bsp
+
+#endif
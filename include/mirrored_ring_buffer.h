@@ -0,0 +1,200 @@
+// A byte ring buffer whose storage is mapped twice, back to back, in virtual memory.
+// Any readable or writable window of up to max_size() bytes is a single contiguous
+// pointer, so parsers can read straight out of the buffer across the wrap point.
+// Note: Linux only (uses memfd_create and mmap)
+
+#ifndef BSP_MIRRORED_RING_BUFFER_H
+#define BSP_MIRRORED_RING_BUFFER_H
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace bsp {
+
+class mirrored_ring_buffer {
+public:
+	using value_type = std::uint8_t;
+	using reference = std::uint8_t&;
+	using const_reference = const std::uint8_t&;
+	using size_type = int;
+
+public:
+	// The capacity is rounded up to a power of two that is a multiple of the page size
+	explicit mirrored_ring_buffer(size_type min_capacity) {
+		if (min_capacity <= 0) throw std::length_error("mirrored_ring_buffer: capacity <= 0");
+		const std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		std::size_t capacity = page_size;
+		while (capacity < static_cast<std::size_t>(min_capacity)) capacity *= 2;
+		if (capacity > static_cast<std::size_t>(max_capacity)) {
+			throw std::length_error("mirrored_ring_buffer: capacity too large");
+		}
+		map(capacity);
+	}
+
+	mirrored_ring_buffer(const mirrored_ring_buffer&) = delete;
+	mirrored_ring_buffer& operator=(const mirrored_ring_buffer&) = delete;
+
+	mirrored_ring_buffer(mirrored_ring_buffer&& other) noexcept
+		: data_(other.data_), capacity_(other.capacity_), head_(other.head_), tail_(other.tail_) {
+		other.data_ = nullptr;
+		other.capacity_ = 0;
+		other.head_ = other.tail_ = 0;
+	}
+
+	mirrored_ring_buffer& operator=(mirrored_ring_buffer&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			std::swap(data_, other.data_);
+			std::swap(capacity_, other.capacity_);
+			std::swap(head_, other.head_);
+			std::swap(tail_, other.tail_);
+		}
+		return *this;
+	}
+
+	~mirrored_ring_buffer() { unmap(); }
+
+	size_type start() const { return static_cast<size_type>(head_ & mask()); }
+
+	size_type count() const { return static_cast<size_type>(tail_ - head_); }
+
+	size_type max_size() const { return static_cast<size_type>(capacity_); }
+
+	size_type free_count() const { return max_size() - count(); }
+
+	bool empty() const { return count() == 0; }
+
+	void clear() { head_ = tail_ = 0; }
+
+	// Add a byte to the end of the ring buffer, overwriting the oldest byte when full
+	void push_back(std::uint8_t value) {
+		data_[tail_ & mask()] = value;
+		if (count() == max_size()) ++head_;
+		++tail_;
+	}
+
+	// Add n bytes to the end with a single copy, overwriting the oldest bytes when full
+	void push_back_n(const void* values, size_type n) {
+		assert(n >= 0);
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(values);
+		if (n > max_size()) {
+			bytes += n - max_size();
+			n = max_size();
+		}
+		std::memcpy(write_data(), bytes, static_cast<std::size_t>(n));
+		tail_ += static_cast<std::size_t>(n);
+		if (tail_ - head_ > capacity_) head_ = tail_ - capacity_;
+	}
+
+	void pop_front() {
+		assert(count() > 0);
+		++head_;
+	}
+
+	void pop_front_n(size_type n) {
+		assert(n >= 0 && n <= count());
+		head_ += static_cast<std::size_t>(n);
+	}
+
+	reference front() { return data_[head_ & mask()]; }
+	const_reference front() const { return data_[head_ & mask()]; }
+
+	reference back() { return count() == 0 ? front() : data_[(tail_ - 1) & mask()]; }
+	const_reference back() const { return count() == 0 ? front() : data_[(tail_ - 1) & mask()]; }
+
+	// Indexes relative to the front, requires index < count()
+	reference operator[](size_type index) { return data()[index]; }
+	const_reference operator[](size_type index) const { return data()[index]; }
+
+	// All count() readable bytes, contiguous
+	std::uint8_t* data() { return data_ + (head_ & mask()); }
+	const std::uint8_t* data() const { return data_ + (head_ & mask()); }
+
+	// The first n readable bytes, contiguous, or nullptr if fewer than n bytes are available
+	const std::uint8_t* peek(size_type n) const { return n <= count() ? data() : nullptr; }
+
+	// All free_count() writable bytes after back(), contiguous
+	// Write into them directly then call commit_push_back()
+	std::uint8_t* write_data() { return data_ + (tail_ & mask()); }
+
+	void commit_push_back(size_type n) {
+		assert(n >= 0 && n <= free_count());
+		tail_ += static_cast<std::size_t>(n);
+	}
+
+	const std::uint8_t* begin() const { return data(); }
+	const std::uint8_t* end() const { return data() + count(); }
+
+protected:
+	static const size_type max_capacity = 1 << 30;
+
+	std::uint8_t* data_ = nullptr;
+	std::size_t capacity_ = 0;
+	std::size_t head_ = 0;
+	std::size_t tail_ = 0;
+
+protected:
+	std::size_t mask() const { return capacity_ - 1; }
+
+	void map(std::size_t capacity) {
+		int fd = memfd_create("bsp_mirrored_ring_buffer", MFD_CLOEXEC);
+		if (fd == -1) throw_errno("mirrored_ring_buffer: memfd_create failed");
+		if (ftruncate(fd, static_cast<off_t>(capacity)) == -1) {
+			close_and_throw(fd, "mirrored_ring_buffer: ftruncate failed");
+		}
+
+		// Reserve both halves first so the second mapping is guaranteed to be adjacent
+		void* base = mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base == MAP_FAILED) close_and_throw(fd, "mirrored_ring_buffer: mmap failed");
+		std::uint8_t* bytes = static_cast<std::uint8_t*>(base);
+		const int prot = PROT_READ | PROT_WRITE;
+		const int flags = MAP_SHARED | MAP_FIXED;
+		if (mmap(bytes, capacity, prot, flags, fd, 0) == MAP_FAILED ||
+			mmap(bytes + capacity, capacity, prot, flags, fd, 0) == MAP_FAILED) {
+			munmap(base, 2 * capacity);
+			close_and_throw(fd, "mirrored_ring_buffer: mmap failed");
+		}
+		close(fd); // The mappings keep the memory alive
+
+		data_ = bytes;
+		capacity_ = capacity;
+	}
+
+	void unmap() {
+		if (data_) munmap(data_, 2 * capacity_);
+		data_ = nullptr;
+	}
+
+	[[noreturn]] static void throw_errno(const char* message) {
+		throw std::system_error(errno, std::generic_category(), message);
+	}
+
+	[[noreturn]] static void close_and_throw(int fd, const char* message) {
+		const int error = errno;
+		close(fd);
+		throw std::system_error(error, std::generic_category(), message);
+	}
+};
+
+inline std::ostream& operator<<(std::ostream& out, const mirrored_ring_buffer& ring) {
+	return out << "mirrored_ring_buffer<" << ring.max_size() << "> {" << ring.count() << " bytes}";
+}
+
+} // namespace bsp
+
+#endif // defined(__linux__)
+
+#endif
@@ -23,6 +23,10 @@
 #include <typeinfo>
 #include <vector>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define HAS_BAD_ARRAY_NEW_LENGTH
 
 // #if defined(__GNUC__) // && !defined(__clang__)
@@ -312,7 +316,10 @@ private:
 	size_type di_ = 0;
 	size_type end_i_ = 0;
 	size_type end_di_ = 0;
+	size_type end_ri_ = 0;
 	const typename storage_pool::storage_type* db_ = nullptr;
+
+	void seek(size_type ri);
 	
 	template <typename T> friend class object_pool_const_iterator;	
 };
@@ -328,7 +335,7 @@ public:
 public:
 	object_pool_const_iterator(const object_pool& array, size_type index, size_type end_index);
 	object_pool_const_iterator(const object_pool_const_iterator&) = default;
-	object_pool_const_iterator(const object_pool_iterator<object_pool>& it):object_pool_(it.object_pool_), storage_pool_(it.storage_pool_), i_(it.i_), di_(it.di_), end_i_(it.end_i_), end_di_(it.end_di_), db_(it.db_){}
+	object_pool_const_iterator(const object_pool_iterator<object_pool>& it):object_pool_(it.object_pool_), storage_pool_(it.storage_pool_), i_(it.i_), di_(it.di_), end_i_(it.end_i_), end_di_(it.end_di_), end_ri_(it.end_ri_), db_(it.db_){}
 	object_pool_const_iterator& operator++();
 	object_pool_const_iterator operator++(int){ object_pool_const_iterator tmp(*this); ++(*this); return tmp; }
 	bool operator==(const object_pool_const_iterator& rhs) const;
@@ -344,7 +351,10 @@ private:
 	size_type di_ = 0;
 	size_type end_i_ = 0;
 	size_type end_di_ = 0;
+	size_type end_ri_ = 0;
 	const typename storage_pool::storage_type* db_ = nullptr;
+
+	void seek(size_type ri);
 };
 } // namespace detail
 
@@ -353,10 +363,37 @@ namespace detail {
 	struct default_object_pool_policy {
 		static const bool store_id_in_object = false;
 		static const bool shrink_after_clear = false;
+		// Optional: maintain a dirty bit per object (see object_pool::mark_dirty)
+		static const bool track_dirty_objects = false;
+		// Optional: cache is_object_iterable in a bitmap (see object_pool::set_iterable)
+		static const bool track_iterable_objects = false;
 		static bool is_object_iterable(const T&){ return true; }
 		static void set_object_id(T&, const ID&){}
 		static ID get_object_id(const T&){return 0;}
 	};
+
+	// Optional policy members default to false if a policy doesn't declare them
+	template <typename Policy, typename Enable = void> struct policy_tracks_dirty_objects : std::false_type {};
+	template <typename Policy>
+	struct policy_tracks_dirty_objects<Policy, typename std::enable_if<Policy::track_dirty_objects>::type> : std::true_type {};
+	template <typename Policy, typename Enable = void> struct policy_tracks_iterable_objects : std::false_type {};
+	template <typename Policy>
+	struct policy_tracks_iterable_objects<Policy, typename std::enable_if<Policy::track_iterable_objects>::type> : std::true_type {};
+
+	inline int count_trailing_zeros(uint64_t word){
+		assert(word != 0);
+	#if defined(__GNUC__)
+		return __builtin_ctzll(word);
+	#elif defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index = 0;
+		_BitScanForward64(&index, word);
+		return static_cast<int>(index);
+	#else
+		int index = 0;
+		while ((word & 1) == 0) { word >>= 1; ++index; }
+		return index;
+	#endif
+	}
 }
 
 class object_pool_base {
@@ -391,6 +428,7 @@ public:
 	{
 		if (size > max_size()) throw std::length_error("object_pool: constructor size too large");
 		log_allocation_internal(objects_.size(), objects_.bytes());
+		resize_bitmaps();
 		clear();
 	}
 
@@ -410,6 +448,8 @@ public:
 		if (object_policy::store_id_in_object){
 			object_policy::set_object_id(*nv, in.id);
 		}
+		if (track_dirty_objects) set_bit(dirty_bits_, in.index);
+		if (track_iterable_objects && object_policy::is_object_iterable(*nv)) set_bit(iterable_bits_, in.index);
 		return { in.id, nv };
 	}
 
@@ -420,6 +460,8 @@ public:
 		if (object_policy::store_id_in_object){
 			object_policy::set_object_id(*nv, in.id);
 		}
+		if (track_dirty_objects) set_bit(dirty_bits_, in.index);
+		if (track_iterable_objects && object_policy::is_object_iterable(*nv)) set_bit(iterable_bits_, in.index);
 		return { in.id, nv };
 	}
 
@@ -442,6 +484,10 @@ public:
 		if (in.index != num_objects_ - 1) {
 			move_back_into(target, in);
 		}
+		else {
+			if (track_dirty_objects) clear_bit(dirty_bits_, in.index);
+			if (track_iterable_objects) clear_bit(iterable_bits_, in.index);
+		}
 		num_objects_--;
 
 		// Update enqueue
@@ -455,6 +501,8 @@ public:
 			destroy(objects_[i]);
 		}
 		num_objects_ = 0;
+		std::fill(dirty_bits_.begin(), dirty_bits_.end(), 0);
+		std::fill(iterable_bits_.begin(), iterable_bits_.end(), 0);
 		for (size_type i = 0; i < max_size_; ++i) {
 			auto& index = indices_[i];
 			index.id = static_cast<id_type>(i);
@@ -473,6 +521,7 @@ public:
 				capacity_ -= count;
 			}
 			assert(capacity_ == initial_capacity_);
+			resize_bitmaps();
 		}
 	}
 
@@ -522,6 +571,7 @@ public:
 	static constexpr size_type max_size() { return max_size_ - 1; }
 
 	iterator begin() { 
+		if (track_iterable_objects) return iterator(*this, next_iterable_index(0, size()), size());
 		auto it   = iterator(*this, 0, size());
 		auto end_ = iterator(*this, size(), size());
 		while (!object_policy::is_object_iterable(*it) && it != end_){
@@ -533,6 +583,7 @@ public:
 	iterator end() { return iterator(*this, size(), size()); }
 
 	const_iterator begin() const { 
+		if (track_iterable_objects) return const_iterator(*this, next_iterable_index(0, size()), size());
 		auto it   = const_iterator(*this, 0, size());
 		auto end_ = const_iterator(*this, size(), size());
 		while (!object_policy::is_object_iterable(*it) && it != end_){
@@ -546,6 +597,66 @@ public:
 	const_iterator cbegin() const { return begin(); }
 
 	const_iterator cend() const { return end(); }
+
+	// Dirty tracking (requires ObjectPolicy::track_dirty_objects)
+	// Objects are dirty after construction and after mark_dirty(), until visited by consume_dirty()
+	void mark_dirty(id_type id) {
+		static_assert(track_dirty_objects, "object_pool: policy doesn't track dirty objects");
+		assert(count(id) == 1);
+		set_bit(dirty_bits_, index(id).index);
+	}
+
+	bool is_dirty(id_type id) const {
+		static_assert(track_dirty_objects, "object_pool: policy doesn't track dirty objects");
+		assert(count(id) == 1);
+		return test_bit(dirty_bits_, index(id).index);
+	}
+
+	void clear_dirty() {
+		std::fill(dirty_bits_.begin(), dirty_bits_.end(), 0);
+	}
+
+	// Calls fn(object) for each dirty object and clears its dirty bit
+	// Scans one 64-bit word per 64 objects, so cost is O(size / 64 + dirty objects)
+	// Note: fn must not construct or remove objects
+	template<typename Fn> size_type consume_dirty(Fn&& fn) {
+		static_assert(track_dirty_objects, "object_pool: policy doesn't track dirty objects");
+		size_type visited = 0;
+		const size_type num_words = (num_objects_ + 63) / 64;
+		for (size_type w = 0; w < num_words; ++w) {
+			uint64_t word = dirty_bits_[w];
+			if (word == 0) continue;
+			dirty_bits_[w] = 0;
+			while (word != 0) {
+				const size_type i = w * 64 + detail::count_trailing_zeros(word);
+				word &= word - 1;
+				fn(objects_[i]);
+				visited++;
+			}
+		}
+		return visited;
+	}
+
+	// Iterable tracking (requires ObjectPolicy::track_iterable_objects)
+	// is_object_iterable is evaluated once on construction and cached in a bitmap,
+	// so iterators jump between iterable objects without touching the others.
+	// Call set_iterable() or update_iterable() when an object's iterability changes.
+	void set_iterable(id_type id, bool iterable) {
+		static_assert(track_iterable_objects, "object_pool: policy doesn't track iterable objects");
+		assert(count(id) == 1);
+		if (iterable) set_bit(iterable_bits_, index(id).index);
+		else clear_bit(iterable_bits_, index(id).index);
+	}
+
+	void update_iterable(id_type id) {
+		set_iterable(id, object_policy::is_object_iterable((*this)[id]));
+	}
+
+	bool is_iterable(id_type id) const {
+		static_assert(track_iterable_objects, "object_pool: policy doesn't track iterable objects");
+		assert(count(id) == 1);
+		return test_bit(iterable_bits_, index(id).index);
+	}
 	
 	bool debug_check_internal_consistency() const {
 		// trace freelist		
@@ -573,6 +684,8 @@ public:
 
 protected:
 	static const size_type max_size_ = 0xffff;
+	static const bool track_dirty_objects = detail::policy_tracks_dirty_objects<ObjectPolicy>::value;
+	static const bool track_iterable_objects = detail::policy_tracks_iterable_objects<ObjectPolicy>::value;
 	size_type initial_capacity_ = 0;
 	size_type capacity_ = 0;
 	size_type num_objects_ = 0;
@@ -597,6 +710,8 @@ public:
 protected:
 	std::array<index_type, max_size_> indices_;
 	storage_pool objects_;
+	std::vector<uint64_t> dirty_bits_; // One bit per dense object slot (if tracking)
+	std::vector<uint64_t> iterable_bits_; // One bit per dense object slot (if tracking)
 
 protected:
 	uint16_t mask_index(id_type id) const {
@@ -613,6 +728,47 @@ protected:
 		}
 		size_type num_new_objects = result.second;
 		log_allocation_internal(num_new_objects, num_new_objects * objects_.size_of_value());
+		resize_bitmaps();
+	}
+
+	void resize_bitmaps() {
+		const size_type num_words = (objects_.size() + 63) / 64;
+		if (track_dirty_objects) dirty_bits_.resize(num_words, 0);
+		if (track_iterable_objects) iterable_bits_.resize(num_words, 0);
+	}
+
+	static void set_bit(std::vector<uint64_t>& bits, size_type i) {
+		bits[i / 64] |= uint64_t(1) << (i % 64);
+	}
+
+	static void clear_bit(std::vector<uint64_t>& bits, size_type i) {
+		bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+	}
+
+	static bool test_bit(const std::vector<uint64_t>& bits, size_type i) {
+		return (bits[i / 64] >> (i % 64)) & 1;
+	}
+
+	static void move_bit(std::vector<uint64_t>& bits, size_type from, size_type to) {
+		if (test_bit(bits, from)) set_bit(bits, to);
+		else clear_bit(bits, to);
+		clear_bit(bits, from);
+	}
+
+	// Returns the first dense index in [from, to) that is iterable, or to
+	size_type next_iterable_index(size_type from, size_type to) const {
+		if (from >= to) return to;
+		size_type w = from / 64;
+		const size_type last_word = (to - 1) / 64;
+		uint64_t word = iterable_bits_[w] & (~uint64_t(0) << (from % 64));
+		while (true) {
+			if (word != 0) {
+				const size_type i = w * 64 + detail::count_trailing_zeros(word);
+				return i < to ? i : to;
+			}
+			if (++w > last_word) return to;
+			word = iterable_bits_[w];
+		}
 	}
 
 	index_type& new_index() {
@@ -641,6 +797,9 @@ protected:
 	void move_back_into(T& target, index_type& index_){
 		new (&target) T(std::move(objects_[num_objects_ - 1]));
 		destroy(objects_[num_objects_ - 1]);
+		// The moved object keeps its tracked state in its new slot
+		if (track_dirty_objects) move_bit(dirty_bits_, num_objects_ - 1, index_.index);
+		if (track_iterable_objects) move_bit(iterable_bits_, num_objects_ - 1, index_.index);
 		if (object_policy::store_id_in_object){
 			index(object_policy::get_object_id(target)).index = index_.index;
 		}
@@ -708,7 +867,7 @@ namespace bsp {
 namespace detail {
 
 template<class object_pool>
-object_pool_iterator<object_pool>::object_pool_iterator(object_pool& array, typename object_pool::size_type ri, typename object_pool::size_type end_ri) : object_pool_(array), storage_pool_(array.objects_), i_(0), di_(0), end_i_(0), end_di_(0) {
+object_pool_iterator<object_pool>::object_pool_iterator(object_pool& array, typename object_pool::size_type ri, typename object_pool::size_type end_ri) : object_pool_(array), storage_pool_(array.objects_), i_(0), di_(0), end_i_(0), end_di_(0), end_ri_(end_ri) {
 	for (; di_ < storage_pool_.storage_count(); di_++) {
 		auto& dbz = storage_pool_.storage(di_);
 		if (ri >= dbz.offset && ri < (dbz.offset + dbz.count)) {
@@ -729,6 +888,11 @@ object_pool_iterator<object_pool>::object_pool_iterator(object_pool& array, type
 
 template<class object_pool>
 object_pool_iterator<object_pool>& object_pool_iterator<object_pool>::operator++() {
+	if (object_pool::track_iterable_objects) {
+		// Jump straight to the next set bit in the iterable bitmap
+		seek(object_pool_.next_iterable_index(db_->offset + i_ + 1, end_ri_));
+		return *this;
+	}
 	while (true) {
 		++i_;
 		if (i_ == db_->count) {
@@ -745,6 +909,19 @@ object_pool_iterator<object_pool>& object_pool_iterator<object_pool>::operator++
 	return *this;
 }
 
+template<class object_pool>
+void object_pool_iterator<object_pool>::seek(typename object_pool::size_type ri) {
+	if (ri >= end_ri_) {
+		i_ = end_i_;
+		di_ = end_di_;
+		return;
+	}
+	while (ri >= db_->offset + db_->count) {
+		db_ = &storage_pool_.storage(++di_);
+	}
+	i_ = ri - db_->offset;
+}
+
 template<class object_pool>
 bool object_pool_iterator<object_pool>::operator==(const object_pool_iterator<object_pool>& rhs) const {
 	return (i_ == rhs.i_ && di_ == rhs.di_) || (di_ == rhs.di_ && i_ >= rhs.i_) || (di_ > rhs.di_);
@@ -762,7 +939,7 @@ template<class object_pool> typename object_pool_iterator<object_pool>::pointer
 template<class object_pool> typename object_pool_iterator<object_pool>::const_pointer object_pool_iterator<object_pool>::operator->() const { return &db_->data[i_]; }
 
 template<class object_pool>
-object_pool_const_iterator<object_pool>::object_pool_const_iterator(const object_pool& array, typename object_pool::size_type ri, typename object_pool::size_type end_ri) : object_pool_(array), storage_pool_(array.objects_), i_(0), di_(0), end_i_(0), end_di_(0) {
+object_pool_const_iterator<object_pool>::object_pool_const_iterator(const object_pool& array, typename object_pool::size_type ri, typename object_pool::size_type end_ri) : object_pool_(array), storage_pool_(array.objects_), i_(0), di_(0), end_i_(0), end_di_(0), end_ri_(end_ri) {
 	for (; di_ < storage_pool_.storage_count(); di_++) {
 		auto& dbz = storage_pool_.storage(di_);
 		if (ri >= dbz.offset && ri < (dbz.offset + dbz.count)) {
@@ -783,6 +960,11 @@ object_pool_const_iterator<object_pool>::object_pool_const_iterator(const object
 
 template<class object_pool>
 object_pool_const_iterator<object_pool>& object_pool_const_iterator<object_pool>::operator++() {
+	if (object_pool::track_iterable_objects) {
+		// Jump straight to the next set bit in the iterable bitmap
+		seek(object_pool_.next_iterable_index(db_->offset + i_ + 1, end_ri_));
+		return *this;
+	}
 	while (true) {
 		++i_;
 		if (i_ == db_->count) {
@@ -799,6 +981,19 @@ object_pool_const_iterator<object_pool>& object_pool_const_iterator<object_pool>
 	return *this;
 }
 
+template<class object_pool>
+void object_pool_const_iterator<object_pool>::seek(typename object_pool::size_type ri) {
+	if (ri >= end_ri_) {
+		i_ = end_i_;
+		di_ = end_di_;
+		return;
+	}
+	while (ri >= db_->offset + db_->count) {
+		db_ = &storage_pool_.storage(++di_);
+	}
+	i_ = ri - db_->offset;
+}
+
 template<class object_pool>
 bool object_pool_const_iterator<object_pool>::operator==(const object_pool_const_iterator<object_pool>& rhs) const {
 	return (i_ == rhs.i_ && di_ == rhs.di_) || (di_ == rhs.di_ && i_ >= rhs.i_) || (di_ > rhs.di_);
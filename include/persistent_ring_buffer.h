@@ -0,0 +1,277 @@
+// A ring buffer of fixed size records stored in a memory mapped file, for keeping the last
+// events of a process across a crash. push_back has ring_buffer's overwrite-oldest
+// semantics and is plain memory writes into the shared mapping: the kernel owns the pages,
+// so everything pushed before the process dies is in the file afterwards.
+// The file is a header page (magic, record size, capacity, head and tail) followed by the
+// records. Use persistent_ring_buffer<T>::recover(path) to read the ordered records back.
+// A new log is written to a temporary file next to path and renamed into place, so path
+// never names a log without its header, even if the process dies while creating it.
+// Note: this survives a process crash, call flush() to also survive a power loss.
+// Note: POSIX only (uses mmap)
+
+#ifndef BSP_PERSISTENT_RING_BUFFER_H
+#define BSP_PERSISTENT_RING_BUFFER_H
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bsp {
+
+template<typename T> class persistent_ring_buffer {
+	static_assert(std::is_trivially_copyable<T>::value, "persistent_ring_buffer requires a trivially copyable T");
+
+public:
+	using value_type = T;
+	using const_reference = const T&;
+	using size_type = int;
+
+public:
+	// Opens the log at path, creating it with room for capacity records if it doesn't exist
+	// or is empty. An existing log is resumed, it must have been created with the same T and capacity
+	persistent_ring_buffer(const std::string& path, size_type capacity) {
+		if (capacity <= 0) throw std::length_error("persistent_ring_buffer: capacity <= 0");
+		int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+		if (fd == -1 && errno != ENOENT) throw_errno("persistent_ring_buffer: open failed");
+		struct stat st;
+		if (fd != -1 && fstat(fd, &st) == -1) close_and_throw(fd, "persistent_ring_buffer: fstat failed");
+		if (fd == -1 || st.st_size == 0) {
+			if (fd != -1) close(fd);
+			create(path, capacity);
+			fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+			if (fd == -1) throw_errno("persistent_ring_buffer: open failed");
+			if (fstat(fd, &st) == -1) close_and_throw(fd, "persistent_ring_buffer: fstat failed");
+		}
+
+		const std::size_t size = file_size(static_cast<std::size_t>(capacity));
+		if (static_cast<std::size_t>(st.st_size) != size) {
+			close(fd);
+			throw std::runtime_error("persistent_ring_buffer: " + path + " has a different capacity or record size");
+		}
+
+		void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED) close_and_throw(fd, "persistent_ring_buffer: mmap failed");
+		close(fd); // The mapping keeps the file open
+		map_ = static_cast<std::uint8_t*>(base);
+		map_size_ = size;
+
+		std::string error = validate(*header(), size);
+		if (error.empty() && header()->capacity != static_cast<std::uint64_t>(capacity)) error = "has a different capacity";
+		if (!error.empty()) {
+			unmap();
+			throw std::runtime_error("persistent_ring_buffer: " + path + " " + error);
+		}
+	}
+
+	persistent_ring_buffer(const persistent_ring_buffer&) = delete;
+	persistent_ring_buffer& operator=(const persistent_ring_buffer&) = delete;
+
+	// A moved-from ring owns no mapping: it is empty with a max_size() of 0, clear() and flush() do
+	// nothing and push_back throws. Assign a ring to it to use it again.
+	persistent_ring_buffer(persistent_ring_buffer&& other) noexcept : map_(other.map_), map_size_(other.map_size_) {
+		other.map_ = nullptr;
+		other.map_size_ = 0;
+	}
+
+	persistent_ring_buffer& operator=(persistent_ring_buffer&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			std::swap(map_, other.map_);
+			std::swap(map_size_, other.map_size_);
+		}
+		return *this;
+	}
+
+	~persistent_ring_buffer() { unmap(); }
+
+	size_type count() const { return map_ ? static_cast<size_type>(header()->tail - header()->head) : 0; }
+
+	size_type max_size() const { return map_ ? static_cast<size_type>(header()->capacity) : 0; }
+
+	bool empty() const { return count() == 0; }
+
+	// Total number of records ever pushed, including overwritten ones
+	std::uint64_t total_pushed() const { return map_ ? header()->tail : 0; }
+
+	void clear() {
+		if (!map_) return;
+		header_type* h = header();
+		h->head = h->tail;
+	}
+
+	// Append a record, overwriting the oldest one when full
+	// When full, head moves first so a crash mid-write never exposes a half overwritten record,
+	// and tail moves last so the new record only becomes visible once it is complete.
+	void push_back(const T& value) {
+		if (!map_) throw std::logic_error("persistent_ring_buffer: push_back on a moved-from ring");
+		header_type* h = header();
+		const std::uint64_t tail = h->tail;
+		if (tail - h->head == h->capacity) {
+			h->head = tail - h->capacity + 1;
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		}
+		std::memcpy(records() + (tail % h->capacity), &value, sizeof(T));
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+		h->tail = tail + 1;
+	}
+
+	// Relative to the front, requires index < count()
+	const_reference operator[](size_type index) const {
+		assert(index >= 0 && index < count());
+		return records()[(header()->head + static_cast<std::uint64_t>(index)) % header()->capacity];
+	}
+
+	const_reference front() const { return (*this)[0]; }
+
+	const_reference back() const { return (*this)[count() - 1]; }
+
+	// Write the mapping back to the file, so the records also survive the machine going down
+	void flush() {
+		if (map_ && msync(map_, map_size_, MS_SYNC) == -1) throw_errno("persistent_ring_buffer: msync failed");
+	}
+
+	// Reads the records of a log, oldest first, e.g. after the process that wrote it crashed
+	static std::vector<T> recover(const std::string& path) {
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd == -1) throw_errno("persistent_ring_buffer: open failed");
+		struct stat st;
+		if (fstat(fd, &st) == -1) close_and_throw(fd, "persistent_ring_buffer: fstat failed");
+		const std::size_t size = static_cast<std::size_t>(st.st_size);
+		if (size < header_size) {
+			close(fd);
+			throw std::runtime_error("persistent_ring_buffer: " + path + " is too small");
+		}
+		void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+		if (base == MAP_FAILED) close_and_throw(fd, "persistent_ring_buffer: mmap failed");
+		close(fd);
+
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(base);
+		const header_type& h = *reinterpret_cast<const header_type*>(bytes);
+		const std::string error = validate(h, size);
+		if (!error.empty()) {
+			munmap(base, size);
+			throw std::runtime_error("persistent_ring_buffer: " + path + " " + error);
+		}
+		// Records are aligned: the mapping is page aligned and sizeof(T) is a multiple of alignof(T)
+		const T* records = reinterpret_cast<const T*>(bytes + header_size);
+		std::vector<T> values;
+		values.reserve(static_cast<std::size_t>(h.tail - h.head));
+		for (std::uint64_t i = h.head; i != h.tail; ++i) values.push_back(records[i % h.capacity]);
+		munmap(base, size);
+		return values;
+	}
+
+protected:
+	static const std::size_t header_size = 4096;
+	static const std::uint32_t version = 1;
+	static constexpr const char* magic = "BSPRING";
+
+	struct header_type {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t record_size;
+		std::uint64_t capacity;
+		std::uint64_t head; // Free-running record indices, head <= tail <= head + capacity
+		std::uint64_t tail;
+	};
+	static_assert(sizeof(header_type) <= header_size, "header_type doesn't fit in the header page");
+
+	std::uint8_t* map_ = nullptr;
+	std::size_t map_size_ = 0;
+
+protected:
+	header_type* header() { return reinterpret_cast<header_type*>(map_); }
+	const header_type* header() const { return reinterpret_cast<const header_type*>(map_); }
+
+	T* records() { return reinterpret_cast<T*>(map_ + header_size); }
+	const T* records() const { return reinterpret_cast<const T*>(map_ + header_size); }
+
+	static std::size_t file_size(std::size_t capacity) { return header_size + capacity * sizeof(T); }
+
+	// Writes an empty log to a temporary file in the same directory and renames it to path
+	// A crash part way leaves at most a stray path.XXXXXX file, never a log without a header
+	static void create(const std::string& path, size_type capacity) {
+		std::string temp = path + ".XXXXXX";
+		const int fd = mkstemp(&temp[0]);
+		if (fd == -1) throw_errno("persistent_ring_buffer: mkstemp failed");
+
+		header_type h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, magic, sizeof(h.magic));
+		h.version = version;
+		h.record_size = sizeof(T);
+		h.capacity = static_cast<std::uint64_t>(capacity);
+		const std::size_t size = file_size(static_cast<std::size_t>(capacity));
+		if (ftruncate(fd, static_cast<off_t>(size)) == -1 || pwrite(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) ||
+			fchmod(fd, 0644) == -1) {
+			const int error = errno;
+			close(fd);
+			unlink(temp.c_str());
+			throw std::system_error(error, std::generic_category(), "persistent_ring_buffer: writing the header failed");
+		}
+		close(fd);
+		if (std::rename(temp.c_str(), path.c_str()) == -1) {
+			const int error = errno;
+			unlink(temp.c_str());
+			throw std::system_error(error, std::generic_category(), "persistent_ring_buffer: rename failed");
+		}
+	}
+
+	// Returns what is wrong with a header, or an empty string if it describes a valid log
+	static std::string validate(const header_type& h, std::size_t size) {
+		if (std::memcmp(h.magic, magic, sizeof(h.magic)) != 0) return "is not a persistent_ring_buffer";
+		if (h.version != version) return "has an unsupported version";
+		if (h.record_size != sizeof(T)) return "has a different record size";
+		if (h.capacity == 0 || file_size(static_cast<std::size_t>(h.capacity)) != size) return "has a corrupt capacity";
+		if (h.head > h.tail || h.tail - h.head > h.capacity) return "has corrupt head and tail";
+		return std::string();
+	}
+
+	void unmap() {
+		if (map_) munmap(map_, map_size_);
+		map_ = nullptr;
+	}
+
+	[[noreturn]] static void throw_errno(const char* message) {
+		throw std::system_error(errno, std::generic_category(), message);
+	}
+
+	[[noreturn]] static void close_and_throw(int fd, const char* message) {
+		const int error = errno;
+		close(fd);
+		throw std::system_error(error, std::generic_category(), message);
+	}
+};
+
+template<typename T> const std::size_t persistent_ring_buffer<T>::header_size;
+template<typename T> const std::uint32_t persistent_ring_buffer<T>::version;
+template<typename T> constexpr const char* persistent_ring_buffer<T>::magic;
+
+template<typename T_> std::ostream& operator<<(std::ostream& out, const persistent_ring_buffer<T_>& ring) {
+	return out << "persistent_ring_buffer<" << ring.max_size() << "> {" << ring.count() << " records}";
+}
+
+} // namespace bsp
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif
@@ -1,12 +1,18 @@
 #ifndef BSP_RING_BUFFER_H
 #define BSP_RING_BUFFER_H
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <ostream>
 #include <utility>
 
@@ -23,71 +29,252 @@ struct is_iterator<
 						 typename std::iterator_traits<T_>::iterator_category>::value>::type>
 	: std::true_type {};
 
+constexpr bool is_power_of_two(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+// Tracks which slots of a ring with Capacity slots are in use
+// Generic capacities keep a start index and a count and wrap with a compare
+template<int Capacity, bool PowerOfTwo = is_power_of_two(Capacity)> class ring_cursors {
+public:
+	using size_type = int;
+
+	size_type start() const { return start_; }
+
+	size_type count() const { return count_; }
+
+	// Requires index < 2 * Capacity, which holds for every index formed from start() + offset
+	static inline size_type wrap(size_type index) { return index >= Capacity ? index - Capacity : index; }
+
+protected:
+	size_type start_ = 0;
+	size_type count_ = 0;
+
+protected:
+	// Slot that the next push_back writes to
+	size_type end_index() const { return wrap(start_ + count_); }
+
+	// Call after writing to end_index(), overwrites the oldest element if full
+	void advance_end() {
+		if (count_ >= Capacity)
+			advance_end_full();
+		else
+			advance_end_not_full();
+	}
+
+	// For callers that already know whether the ring is full
+	void advance_end_not_full() { count_++; }
+
+	void advance_end_full() { start_ = wrap(start_ + 1); }
+
+	void advance_start() {
+		start_ = wrap(start_ + 1);
+		count_--;
+	}
+
+	void retreat_end() { count_--; }
+
+	// Call after writing n <= Capacity slots from end_index(), overwrites the oldest elements
+	void advance_end_n(size_type n) {
+		const size_type total = count_ + n;
+		if (total > Capacity) {
+			start_ = wrap(start_ + total - Capacity);
+			count_ = Capacity;
+		}
+		else
+			count_ = total;
+	}
+
+	void advance_start_n(size_type n) {
+		start_ = wrap(start_ + n);
+		count_ -= n;
+	}
+
+	void reset() {
+		start_ = 0;
+		count_ = 0;
+	}
+};
+
+// Power of two capacities keep free-running cursors and wrap with a mask
+template<int Capacity> class ring_cursors<Capacity, true> {
+public:
+	using size_type = int;
+
+	size_type start() const { return static_cast<size_type>(head_ & mask); }
+
+	size_type count() const { return static_cast<size_type>(tail_ - head_); }
+
+	static inline size_type wrap(size_type index) { return index & static_cast<size_type>(mask); }
+
+protected:
+	static const std::uint32_t mask = static_cast<std::uint32_t>(Capacity) - 1;
+	std::uint32_t head_ = 0;
+	std::uint32_t tail_ = 0;
+
+protected:
+	size_type end_index() const { return static_cast<size_type>(tail_ & mask); }
+
+	void advance_end() {
+		if (tail_ - head_ == static_cast<std::uint32_t>(Capacity)) ++head_;
+		++tail_;
+	}
+
+	void advance_end_not_full() { ++tail_; }
+
+	void advance_end_full() {
+		++head_;
+		++tail_;
+	}
+
+	void advance_start() { ++head_; }
+
+	void retreat_end() { --tail_; }
+
+	void advance_end_n(size_type n) {
+		tail_ += static_cast<std::uint32_t>(n);
+		if (tail_ - head_ > static_cast<std::uint32_t>(Capacity)) head_ = tail_ - static_cast<std::uint32_t>(Capacity);
+	}
+
+	void advance_start_n(size_type n) { head_ += static_cast<std::uint32_t>(n); }
+
+	void reset() {
+		head_ = 0;
+		tail_ = 0;
+	}
+};
+
+// A contiguous region of a ring buffer
+template<typename T> class ring_span {
+public:
+	using size_type = int;
+
+	ring_span() = default;
+	ring_span(T* data, size_type size):data_(data), size_(size){}
+
+	T* data() const { return data_; }
+	size_type size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	T* begin() const { return data_; }
+	T* end() const { return data_ + size_; }
+
+protected:
+	T* data_ = nullptr;
+	size_type size_ = 0;
+};
+
+// Random access iterators over the elements in order
+// i_ is the position relative to the front and offset_ is the ring's start(), so positions
+// are compared and subtracted directly and only dereferencing wraps into the ring
 template <class ring_buffer>
-class ring_buffer_iterator : public std::iterator<std::bidirectional_iterator_tag, typename ring_buffer::value_type> {
+class ring_buffer_iterator : public std::iterator<std::random_access_iterator_tag, typename ring_buffer::value_type> {
 public:
     using reference       = typename ring_buffer::reference;
-    using const_reference = typename ring_buffer::const_reference;
+    using pointer         = typename ring_buffer::value_type*;
     using size_type       = typename ring_buffer::size_type;
+    using difference_type = std::ptrdiff_t;
 
 public:
-    ring_buffer_iterator(ring_buffer& ring):ring_(ring), offset_(ring.start()),i_(ring.count()) {}
-    ring_buffer_iterator(ring_buffer& ring, size_type offset):ring_(ring),offset_(offset){}		
+    ring_buffer_iterator() = default;
+    ring_buffer_iterator(ring_buffer& ring):ring_(&ring), offset_(ring.start()), i_(ring.count()) {}
+    ring_buffer_iterator(ring_buffer& ring, size_type offset):ring_(&ring), offset_(offset){}
     ring_buffer_iterator& operator++(){ ++i_; return *this; }
     ring_buffer_iterator operator++(int){ ring_buffer_iterator tmp(*this); ++(*this); return tmp; }
-    ring_buffer_iterator& operator--(){ i_ = (i_ + ring_.max_size() - 1) % ring_.max_size(); return *this; }
+    ring_buffer_iterator& operator--(){ --i_; return *this; }
     ring_buffer_iterator operator--(int){ ring_buffer_iterator tmp(*this); --(*this); return tmp; }
-    bool operator==(const ring_buffer_iterator& rhs) const { return &ring_ == &rhs.ring_ && i_ == rhs.i_; }
+    ring_buffer_iterator& operator+=(difference_type n){ i_ += static_cast<size_type>(n); return *this; }
+    ring_buffer_iterator& operator-=(difference_type n){ i_ -= static_cast<size_type>(n); return *this; }
+    ring_buffer_iterator operator+(difference_type n) const { ring_buffer_iterator tmp(*this); return tmp += n; }
+    ring_buffer_iterator operator-(difference_type n) const { ring_buffer_iterator tmp(*this); return tmp -= n; }
+    friend ring_buffer_iterator operator+(difference_type n, const ring_buffer_iterator& it){ return it + n; }
+    difference_type operator-(const ring_buffer_iterator& rhs) const { return static_cast<difference_type>(i_) - rhs.i_; }
+    bool operator==(const ring_buffer_iterator& rhs) const { return ring_ == rhs.ring_ && i_ == rhs.i_; }
     bool operator!=(const ring_buffer_iterator& rhs) const { return !(*this == rhs); }
-    reference operator*() { return ring_[(i_ + offset_) % ring_.max_size()]; }
-    const_reference operator*() const { return ring_[(i_ + offset_) % ring_.max_size()]; }
-    
+    bool operator<(const ring_buffer_iterator& rhs) const { return i_ < rhs.i_; }
+    bool operator>(const ring_buffer_iterator& rhs) const { return i_ > rhs.i_; }
+    bool operator<=(const ring_buffer_iterator& rhs) const { return i_ <= rhs.i_; }
+    bool operator>=(const ring_buffer_iterator& rhs) const { return i_ >= rhs.i_; }
+    reference operator*() const { return (*ring_)[ring_->wrap(i_ + offset_)]; }
+    pointer operator->() const { return &**this; }
+    reference operator[](difference_type n) const { return (*ring_)[ring_->wrap(i_ + static_cast<size_type>(n) + offset_)]; }
+
 protected:
-    ring_buffer& ring_;
+    ring_buffer* ring_ = nullptr;
     size_type offset_ = 0;
-    size_type i_ = 0;     
+    size_type i_ = 0;
 
-    friend class const_iterator;   
+    template <class> friend class ring_buffer_const_iterator;
 };
 
 template <class ring_buffer>
-class ring_buffer_const_iterator : public std::iterator<std::bidirectional_iterator_tag, typename ring_buffer::value_type> {
+class ring_buffer_const_iterator : public std::iterator<std::random_access_iterator_tag, typename ring_buffer::value_type> {
 public:
-    using reference = typename ring_buffer::const_reference;
-    using size_type = typename ring_buffer::size_type;
+    using reference       = typename ring_buffer::const_reference;
+    using pointer         = const typename ring_buffer::value_type*;
+    using size_type       = typename ring_buffer::size_type;
+    using difference_type = std::ptrdiff_t;
 
 public:
-    ring_buffer_const_iterator(const ring_buffer& ring):ring_(ring), i_(ring.count()), offset_(ring.start()) {}
-    ring_buffer_const_iterator(const ring_buffer& ring, size_type offset):ring_(ring),offset_(offset){}		
-    ring_buffer_const_iterator(const ring_buffer_iterator<ring_buffer>& it):ring_(it.ring_), offset_(it.offset_), i_(it.i_){}        
-    ring_buffer_const_iterator& operator++(){ i_++; return *this; }
+    ring_buffer_const_iterator() = default;
+    ring_buffer_const_iterator(const ring_buffer& ring):ring_(&ring), offset_(ring.start()), i_(ring.count()) {}
+    ring_buffer_const_iterator(const ring_buffer& ring, size_type offset):ring_(&ring), offset_(offset){}
+    ring_buffer_const_iterator(const ring_buffer_iterator<ring_buffer>& it):ring_(it.ring_), offset_(it.offset_), i_(it.i_){}
+    ring_buffer_const_iterator& operator++(){ ++i_; return *this; }
     ring_buffer_const_iterator operator++(int){ ring_buffer_const_iterator tmp(*this); ++(*this); return tmp; }
-    ring_buffer_const_iterator& operator--(){ i_ = (i_ + ring_.max_size() - 1) % ring_.max_size(); return *this; }
+    ring_buffer_const_iterator& operator--(){ --i_; return *this; }
     ring_buffer_const_iterator operator--(int){ ring_buffer_const_iterator tmp(*this); --(*this); return tmp; }
-    bool operator==(const ring_buffer_const_iterator& rhs) const { return &ring_ == &rhs.ring_ && i_ == rhs.i_; }
+    ring_buffer_const_iterator& operator+=(difference_type n){ i_ += static_cast<size_type>(n); return *this; }
+    ring_buffer_const_iterator& operator-=(difference_type n){ i_ -= static_cast<size_type>(n); return *this; }
+    ring_buffer_const_iterator operator+(difference_type n) const { ring_buffer_const_iterator tmp(*this); return tmp += n; }
+    ring_buffer_const_iterator operator-(difference_type n) const { ring_buffer_const_iterator tmp(*this); return tmp -= n; }
+    friend ring_buffer_const_iterator operator+(difference_type n, const ring_buffer_const_iterator& it){ return it + n; }
+    difference_type operator-(const ring_buffer_const_iterator& rhs) const { return static_cast<difference_type>(i_) - rhs.i_; }
+    bool operator==(const ring_buffer_const_iterator& rhs) const { return ring_ == rhs.ring_ && i_ == rhs.i_; }
     bool operator!=(const ring_buffer_const_iterator& rhs) const { return !(*this == rhs); }
-    reference operator*() const { return ring_[(i_ + offset_) % ring_.max_size()]; }
-    
+    bool operator<(const ring_buffer_const_iterator& rhs) const { return i_ < rhs.i_; }
+    bool operator>(const ring_buffer_const_iterator& rhs) const { return i_ > rhs.i_; }
+    bool operator<=(const ring_buffer_const_iterator& rhs) const { return i_ <= rhs.i_; }
+    bool operator>=(const ring_buffer_const_iterator& rhs) const { return i_ >= rhs.i_; }
+    reference operator*() const { return (*ring_)[ring_->wrap(i_ + offset_)]; }
+    pointer operator->() const { return &**this; }
+    reference operator[](difference_type n) const { return (*ring_)[ring_->wrap(i_ + static_cast<size_type>(n) + offset_)]; }
+
 protected:
-    const ring_buffer& ring_;
+    const ring_buffer* ring_ = nullptr;
     size_type offset_ = 0;
     size_type i_ = 0;
 };
 }
 
-template<typename T, int Capacity> class ring_buffer {
+// What ring_buffer::push_back does when the ring is full
+enum class overflow_policy {
+	overwrite,	 // Replace the oldest element (front)
+	reject,		 // Leave the ring unchanged and return false
+	drop_newest	 // Discard the incoming element, leave the ring unchanged and return true
+};
+
+// A fixed-size circular buffer, by default push_back overwrites the oldest element when full
+// Power of two capacities wrap indices with a mask, others with a compare and subtract
+// Every policy counts the elements it loses in dropped(). The policy is a template argument,
+// so push_back tests for a full ring once and the branches of other policies compile away.
+template<typename T, int Capacity, overflow_policy Policy = overflow_policy::overwrite>
+class ring_buffer : public detail_ring_buffer::ring_cursors<Capacity> {
     static_assert(Capacity > 0, "Capacity <= 0!"); 
+    using cursors = detail_ring_buffer::ring_cursors<Capacity>;
 
 public:
     using value_type = T;
     using reference = T&;
 	using const_reference = const T&;
 	using size_type = int;
+    static const overflow_policy policy = Policy;
 
     using iterator = detail_ring_buffer::ring_buffer_iterator<ring_buffer>;
     using const_iterator = detail_ring_buffer::ring_buffer_const_iterator<ring_buffer>;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using span = detail_ring_buffer::ring_span<T>;
+    using const_span = detail_ring_buffer::ring_span<const T>;
+    using segments = std::array<span, 2>;
+    using const_segments = std::array<const_span, 2>;
 
 public:
 
@@ -96,67 +283,195 @@ public:
     template <typename Container>
     ring_buffer(const Container& els):ring_buffer(els.begin(), els.end()){}
     ring_buffer(std::initializer_list<T> list):ring_buffer(list.begin(), list.end()){}
+
+    ring_buffer(const ring_buffer& other):cursors(other), dropped_(other.dropped_){
+        for (size_type i = 0; i < count(); ++i) new (slot(wrap(start() + i))) T(other.get(wrap(start() + i)));
+    }
+
+    ring_buffer(ring_buffer&& other):cursors(other), dropped_(other.dropped_){
+        for (size_type i = 0; i < count(); ++i) new (slot(wrap(start() + i))) T(std::move(other.get(wrap(start() + i))));
+    }
+
+    ring_buffer& operator=(const ring_buffer& other){
+        if (this == &other) return *this;
+        clear();
+        cursors::operator=(other);
+        dropped_ = other.dropped_;
+        for (size_type i = 0; i < count(); ++i) new (slot(wrap(start() + i))) T(other.get(wrap(start() + i)));
+        return *this;
+    }
+
+    ring_buffer& operator=(ring_buffer&& other){
+        if (this == &other) return *this;
+        clear();
+        cursors::operator=(other);
+        dropped_ = other.dropped_;
+        for (size_type i = 0; i < count(); ++i) new (slot(wrap(start() + i))) T(std::move(other.get(wrap(start() + i))));
+        return *this;
+    }
+
+    ~ring_buffer(){
+        destroy_front(count());
+    }
 	
-    size_type start() const { return start_; }
+    using cursors::start;
 
-	size_type count() const { return count_; }
+	using cursors::count;
+
+	using cursors::wrap;
 
 	static constexpr inline size_type max_size() { return Capacity; }
 
 	void clear() {
-		count_ = 0;
-		start_ = 0;
+		destroy_front(count());
+		cursors::reset();
 	}
 
-	bool empty() const { return count_ == 0; }
+	bool empty() const { return count() == 0; }
+
+	bool full() const { return count() == max_size(); }
+
+    // Elements lost to the overflow policy: overwritten, rejected or discarded
+    std::size_t dropped() const { return dropped_; }
+
+    void reset_dropped() { dropped_ = 0; }
 
     bool valid_index(size_type index) const {
-        if (index >= start_) return (index - start_) < count_;
-        else return (max_size() - (start_ - index)) < count_;
+        return wrap(index + max_size() - start()) < count();
     }
 	
     // Add an element to the end of the ring buffer
+    // Returns false if the ring was full and the policy is reject
     template <typename U>
-    void push_back(U&& value){
-        size_type next_index = (start_ + count_) % max_size();
-		data_[next_index] = std::forward<U>(value);
-		if (count_ >= max_size())
-			start_ = (start_ + 1) % max_size();
-		else
-			count_++;
+    bool push_back(U&& value){
+        if (full()) return push_back_full(std::forward<U>(value));
+        new (slot(cursors::end_index())) T(std::forward<U>(value));
+        cursors::advance_end_not_full();
+        return true;
     }
 
     template<class... Args> 
-    void emplace_back(Args&&... args) {
-        size_type next_index = (start_ + count_) % max_size();
-		data_[next_index] = T(std::forward<Args>(args)...);
-		if (count_ >= max_size())
-			start_ = (start_ + 1) % max_size();
-		else
-			count_++;
+    bool emplace_back(Args&&... args) {
+        if (full()){
+            // Neither reject nor drop_newest needs the element, so don't construct it
+            if (Policy != overflow_policy::overwrite){
+                ++dropped_;
+                return Policy == overflow_policy::drop_newest;
+            }
+            return push_back_full(T(std::forward<Args>(args)...));
+        }
+        new (slot(cursors::end_index())) T(std::forward<Args>(args)...);
+        cursors::advance_end_not_full();
+        return true;
     }
 
     void pop_front(){
-        assert(count_ > 0);
-        start_ = (start_ + 1) % max_size();
-        count_--;
+        assert(count() > 0);
+        slot(start())->~T();
+        cursors::advance_start();
     }
 
-    reference front(){ return data_[start_]; }
-    const_reference front() const { return data_[start_]; }
+    void pop_back(){
+        assert(count() > 0);
+        back().~T();
+        cursors::retreat_end();
+    }
+
+    // Add n elements to the end, handling the ones that don't fit like n calls to push_back
+    // Copies in at most two contiguous runs, returns how many of the n elements are in the ring afterwards
+    template <typename Iter>
+    size_type push_back_n(Iter first, size_type n){
+        assert(n >= 0);
+        const size_type num_free = max_size() - count();
+        if (n > num_free) dropped_ += static_cast<std::size_t>(n - num_free);
+        if (Policy != overflow_policy::overwrite && n > num_free){
+            // reject and drop_newest both keep the elements that fit and lose the rest
+            copy_free(first, num_free);
+            return num_free;
+        }
+        if (n > max_size()){
+            std::advance(first, n - max_size());
+            n = max_size();
+        }
+        // Free slots are constructed, slots holding the oldest elements are assigned
+        const size_type num_constructed = std::min(n, num_free);
+        const size_type end_index = cursors::end_index();
+        const size_type first_run = std::min(num_constructed, max_size() - end_index);
+        first = copy_n(first, first_run, slot(end_index), true);
+        first = copy_n(first, num_constructed - first_run, slot(wrap(end_index + first_run)), true);
+        const size_type overwrite_index = wrap(end_index + num_constructed);
+        const size_type second_run = std::min(n - num_constructed, max_size() - overwrite_index);
+        first = copy_n(first, second_run, slot(overwrite_index), false);
+        copy_n(first, n - num_constructed - second_run, slot(wrap(overwrite_index + second_run)), false);
+        cursors::advance_end_n(n);
+        return n;
+    }
+
+    // Remove n <= count() elements from the front
+    void pop_front_n(size_type n){
+        assert(n >= 0 && n <= count());
+        destroy_front(n);
+        cursors::advance_start_n(n);
+    }
+
+    // Move n <= count() elements from the front into out and remove them
+    template <typename OutIter>
+    OutIter pop_front_n(OutIter out, size_type n){
+        assert(n >= 0 && n <= count());
+        for (const span& s: read_segments()){
+            const size_type run = std::min(n, s.size());
+            out = std::move(s.begin(), s.begin() + run, out);
+            n -= run;
+            pop_front_n(run);
+        }
+        return out;
+    }
+
+    // The elements in order as at most two contiguous spans (the second may be empty)
+    segments read_segments(){
+        const size_type first_run = std::min(count(), max_size() - start());
+        return segments {{ span(slot(start()), first_run), span(slot(0), count() - first_run) }};
+    }
+
+    const_segments read_segments() const {
+        const size_type first_run = std::min(count(), max_size() - start());
+        return const_segments {{ const_span(slot(start()), first_run), const_span(slot(0), count() - first_run) }};
+    }
+
+    // The unused slots after back() as at most two contiguous spans
+    // Write into them directly then call commit_push_back()
+    // Note: Unused slots hold no objects, so this requires a trivially copyable T
+    segments write_segments(){
+        static_assert(std::is_trivially_copyable<T>::value, "ring_buffer: write_segments requires a trivially copyable T");
+        const size_type free = max_size() - count();
+        const size_type end_index = cursors::end_index();
+        const size_type first_run = std::min(free, max_size() - end_index);
+        return segments {{ span(slot(end_index), first_run), span(slot(0), free - first_run) }};
+    }
+
+    // Append n elements that were written through write_segments()
+    void commit_push_back(size_type n){
+        static_assert(std::is_trivially_copyable<T>::value, "ring_buffer: commit_push_back requires a trivially copyable T");
+        assert(n >= 0 && n <= max_size() - count());
+        cursors::advance_end_n(n);
+    }
+
+    reference front(){ return get(start()); }
+    const_reference front() const { return get(start()); }
 
-    reference back(){ return count_ == 0 ? front() : data_[(start_ + count_ - 1) % max_size()]; }
-    const_reference back() const { return count_ == 0 ? front() : data_[(start_ + count_ - 1) % max_size()]; }
+    reference back(){ return count() == 0 ? front() : get(wrap(start() + count() - 1)); }
+    const_reference back() const { return count() == 0 ? front() : get(wrap(start() + count() - 1)); }
 
     // Directly indexes into underlying array
-	reference operator[](size_type index) { return data_[index]; }
+	reference operator[](size_type index) { return *slot(index); }
 
-	const_reference operator[](size_type index) const { return data_[index]; }
+	const_reference operator[](size_type index) const { return *slot(index); }
 
+    // Indexes relative to front()
     reference at(size_type index) { return const_cast<reference>(static_cast<const ring_buffer*>(this)->at(index)); }
     const_reference at(size_type index) const {
-		if (index >= 0 && index < count_) {
-			return data_[index];
+		if (index >= 0 && index < count()) {
+			return get(wrap(start() + index));
 		}
 		else {
             throw std::out_of_range("ring_buffer: accessing invalid element");
@@ -184,9 +499,10 @@ public:
     const_reverse_iterator rend() const { return std::reverse_iterator<const_iterator>(begin()); }
 
 protected:
-	std::array<T, Capacity> data_;
-	size_type count_ = 0;
-	size_type start_ = 0;
+    // Slots only hold an object while they are in use, like detail::static_vector
+	using raw_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	raw_type data_[Capacity];
 
 protected:
     template <typename Iter, typename = typename std::enable_if<detail_ring_buffer::is_iterator<Iter>::value>::type>
@@ -194,17 +510,65 @@ protected:
         for (auto it = begin; it != end; ++it) push_back(*it);
     }
 
-	template<typename T_, int Capacity_>
-	friend std::ostream& operator<<(std::ostream&, const ring_buffer<T_,Capacity_>&);
+    T* slot(size_type index){ return reinterpret_cast<T*>(data_ + index); }
+    const T* slot(size_type index) const { return reinterpret_cast<const T*>(data_ + index); }
+    reference get(size_type index){ return *slot(index); }
+    const_reference get(size_type index) const { return *slot(index); }
+
+    std::size_t dropped_ = 0;
+
+    // The full branch of push_back, with the policy known at compile time
+    template <typename U>
+    bool push_back_full(U&& value){
+        ++dropped_;
+        switch (Policy){
+        case overflow_policy::overwrite:
+            get(cursors::end_index()) = std::forward<U>(value);
+            cursors::advance_end_full();
+            return true;
+        case overflow_policy::drop_newest:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Constructs n <= max_size() - count() elements in the free slots
+    template <typename Iter>
+    void copy_free(Iter first, size_type n){
+        const size_type end_index = cursors::end_index();
+        const size_type first_run = std::min(n, max_size() - end_index);
+        first = copy_n(first, first_run, slot(end_index), true);
+        copy_n(first, n - first_run, slot(wrap(end_index + first_run)), true);
+        cursors::advance_end_n(n);
+    }
+
+    void destroy_front(size_type n){
+        for (size_type i = 0; i < n; ++i) slot(wrap(start() + i))->~T();
+    }
+
+    // Copies n elements into a contiguous run, constructing or assigning
+    template <typename Iter>
+    static Iter copy_n(Iter first, size_type n, T* out, bool construct){
+        Iter last = std::next(first, n);
+        if (construct) std::uninitialized_copy(first, last, out);
+        else std::copy(first, last, out);
+        return last;
+    }
+
+	template<typename T_, int Capacity_, overflow_policy Policy_>
+	friend std::ostream& operator<<(std::ostream&, const ring_buffer<T_,Capacity_,Policy_>&);
 };
 
-template<typename T_, int Capacity_> std::ostream& operator<<(std::ostream& out,
-								const ring_buffer<T_,Capacity_>& ring) {
+template<typename T, int Capacity, overflow_policy Policy> const overflow_policy ring_buffer<T, Capacity, Policy>::policy;
+
+template<typename T_, int Capacity_, overflow_policy Policy_> std::ostream& operator<<(std::ostream& out,
+								const ring_buffer<T_,Capacity_,Policy_>& ring) {
 	out << "ring_buffer<" << Capacity_ << "> {";
 	if (ring.empty())
 		out << "}";
 	else {
-        using size_type = typename ring_buffer<T_,Capacity_>::size_type;
+        using size_type = typename ring_buffer<T_,Capacity_,Policy_>::size_type;
         for (size_type i = 0; i < ring.max_size(); ++i){
             if (ring.valid_index(i)) out << ring[i];
             else out << "_";
@@ -215,6 +579,275 @@ template<typename T_, int Capacity_> std::ostream& operator<<(std::ostream& out,
 	return out;
 }
 
+// A circular buffer whose capacity is chosen at runtime
+// Storage is allocated once at construction and only reallocated by reserve() or grow()
+// If PowerOfTwo, the capacity is rounded up to a power of two and indexed with a mask
+template<typename T, bool PowerOfTwo = false, class Allocator = std::allocator<T>> class dynamic_ring_buffer {
+public:
+    using value_type = T;
+    using reference = T&;
+	using const_reference = const T&;
+	using size_type = int;
+    using allocator_type = Allocator;
+
+    using iterator = detail_ring_buffer::ring_buffer_iterator<dynamic_ring_buffer>;
+    using const_iterator = detail_ring_buffer::ring_buffer_const_iterator<dynamic_ring_buffer>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using span = detail_ring_buffer::ring_span<T>;
+    using const_span = detail_ring_buffer::ring_span<const T>;
+    using segments = std::array<span, 2>;
+    using const_segments = std::array<const_span, 2>;
+
+public:
+    explicit dynamic_ring_buffer(size_type capacity, const Allocator& allocator = Allocator()):allocator_(allocator){
+        if (capacity <= 0) throw std::length_error("dynamic_ring_buffer: capacity <= 0");
+        capacity_ = round_capacity(capacity);
+        data_ = allocator_traits::allocate(allocator_, capacity_);
+    }
+
+    // A copy of a moved-from buffer is empty with no storage, like the source
+    dynamic_ring_buffer(const dynamic_ring_buffer& other)
+        :allocator_(allocator_traits::select_on_container_copy_construction(other.allocator_)){
+        if (other.capacity_ == 0) return;
+        capacity_ = other.capacity_;
+        data_ = allocator_traits::allocate(allocator_, capacity_);
+        for (const auto& value: other) push_back(value);
+    }
+
+    dynamic_ring_buffer(dynamic_ring_buffer&& other):allocator_(std::move(other.allocator_)), data_(other.data_), capacity_(other.capacity_), start_(other.start_), count_(other.count_){
+        other.data_ = nullptr;
+        other.capacity_ = 0;
+        other.start_ = other.count_ = 0;
+    }
+
+    dynamic_ring_buffer& operator=(dynamic_ring_buffer other){
+        swap(other);
+        return *this;
+    }
+
+    ~dynamic_ring_buffer(){
+        release();
+    }
+
+    void swap(dynamic_ring_buffer& other){
+        using std::swap;
+        swap(allocator_, other.allocator_);
+        swap(data_, other.data_);
+        swap(capacity_, other.capacity_);
+        swap(start_, other.start_);
+        swap(count_, other.count_);
+    }
+
+    size_type start() const { return start_; }
+
+	size_type count() const { return count_; }
+
+	size_type max_size() const { return capacity_; }
+
+    size_type capacity() const { return capacity_; }
+
+    allocator_type get_allocator() const { return allocator_; }
+
+	void clear() {
+		destroy_front(count_);
+		start_ = 0;
+		count_ = 0;
+	}
+
+	bool empty() const { return count_ == 0; }
+
+    // Wraps an index in [0, 2 * capacity()) with a mask or a single compare, never a division
+    size_type wrap(size_type index) const {
+        if (PowerOfTwo) return index & (capacity_ - 1);
+        else return index >= capacity_ ? index - capacity_ : index;
+    }
+
+    bool valid_index(size_type index) const {
+        return wrap(index + capacity_ - start_) < count_;
+    }
+
+    // Reallocates to hold at least new_capacity elements
+    // Moves the elements to the front of the new storage in a single pass, or copies them if
+    // moving could throw, so if an element throws the ring is left as it was (strong guarantee)
+    void reserve(size_type new_capacity){
+        if (new_capacity <= capacity_) return;
+        new_capacity = round_capacity(new_capacity);
+        T* new_data = allocator_traits::allocate(allocator_, new_capacity);
+        size_type constructed = 0;
+        try {
+            for (; constructed < count_; ++constructed){
+                allocator_traits::construct(allocator_, new_data + constructed, std::move_if_noexcept(data_[wrap(start_ + constructed)]));
+            }
+        }
+        catch (...) {
+            for (size_type i = 0; i < constructed; ++i) allocator_traits::destroy(allocator_, new_data + i);
+            allocator_traits::deallocate(allocator_, new_data, new_capacity);
+            throw;
+        }
+        for (size_type i = 0; i < count_; ++i) allocator_traits::destroy(allocator_, data_ + wrap(start_ + i));
+        if (data_ != nullptr) allocator_traits::deallocate(allocator_, data_, capacity_);
+        data_ = new_data;
+        capacity_ = new_capacity;
+        start_ = 0;
+    }
+
+    // Doubles the capacity, a moved-from buffer (capacity() == 0) gets room for one element
+    void grow(){
+        if (capacity_ > std::numeric_limits<size_type>::max() / 2) throw std::length_error("dynamic_ring_buffer: capacity too large");
+        reserve(capacity_ == 0 ? 1 : capacity_ * 2);
+    }
+
+    // Add an element to the end of the ring buffer, overwriting the oldest element when full
+    template <typename U>
+    void push_back(U&& value){
+        if (capacity_ == 0) grow();
+        if (count_ == capacity_) data_[start_] = std::forward<U>(value);
+        else allocator_traits::construct(allocator_, data_ + end_index(), std::forward<U>(value));
+        advance_end();
+    }
+
+    template<class... Args>
+    void emplace_back(Args&&... args) {
+        if (capacity_ == 0) grow();
+        if (count_ == capacity_) data_[start_] = T(std::forward<Args>(args)...);
+        else allocator_traits::construct(allocator_, data_ + end_index(), std::forward<Args>(args)...);
+        advance_end();
+    }
+
+    void pop_front(){
+        assert(count_ > 0);
+        allocator_traits::destroy(allocator_, data_ + start_);
+        start_ = wrap(start_ + 1);
+        count_--;
+    }
+
+    // Add n elements to the end, overwriting the oldest elements when full
+    template <typename Iter>
+    void push_back_n(Iter first, size_type n){
+        assert(n >= 0);
+        if (capacity_ == 0 && n > 0) grow();
+        if (n > capacity_){
+            std::advance(first, n - capacity_);
+            n = capacity_;
+        }
+        for (size_type i = 0; i < n; ++i, ++first) push_back(*first);
+    }
+
+    // Remove n <= count() elements from the front
+    void pop_front_n(size_type n){
+        assert(n >= 0 && n <= count_);
+        destroy_front(n);
+        start_ = wrap(start_ + n);
+        count_ -= n;
+    }
+
+    // The elements in order as at most two contiguous spans (the second may be empty)
+    segments read_segments(){
+        const size_type first_run = std::min(count_, capacity_ - start_);
+        return segments {{ span(data_ + start_, first_run), span(data_, count_ - first_run) }};
+    }
+
+    const_segments read_segments() const {
+        const size_type first_run = std::min(count_, capacity_ - start_);
+        return const_segments {{ const_span(data_ + start_, first_run), const_span(data_, count_ - first_run) }};
+    }
+
+    reference front(){ return data_[start_]; }
+    const_reference front() const { return data_[start_]; }
+
+    reference back(){ return count_ == 0 ? front() : data_[wrap(start_ + count_ - 1)]; }
+    const_reference back() const { return count_ == 0 ? front() : data_[wrap(start_ + count_ - 1)]; }
+
+    // Directly indexes into underlying array
+	reference operator[](size_type index) { return data_[index]; }
+
+	const_reference operator[](size_type index) const { return data_[index]; }
+
+    // Indexes relative to front()
+    reference at(size_type index) { return const_cast<reference>(static_cast<const dynamic_ring_buffer*>(this)->at(index)); }
+    const_reference at(size_type index) const {
+		if (index >= 0 && index < count_) {
+			return data_[wrap(start_ + index)];
+		}
+		else {
+            throw std::out_of_range("dynamic_ring_buffer: accessing invalid element");
+		}
+	}
+
+    iterator begin() { return iterator(*this, start()); }
+
+    iterator end() { return iterator(*this); }
+
+    const_iterator begin() const { return const_iterator(*this, start()); }
+
+    const_iterator end() const { return const_iterator(*this); }
+
+    const_iterator cbegin() const { return const_iterator(*this, start()); }
+
+    const_iterator cend() const { return const_iterator(*this); }
+
+    reverse_iterator rbegin() { return std::reverse_iterator<iterator>(end()); }
+
+    reverse_iterator rend() { return std::reverse_iterator<iterator>(begin()); }
+
+    const_reverse_iterator rbegin() const { return std::reverse_iterator<const_iterator>(end()); }
+
+    const_reverse_iterator rend() const { return std::reverse_iterator<const_iterator>(begin()); }
+
+protected:
+    using allocator_traits = std::allocator_traits<Allocator>;
+
+    Allocator allocator_;
+    T* data_ = nullptr;
+	size_type capacity_ = 0;
+	size_type start_ = 0;
+	size_type count_ = 0;
+
+protected:
+    static size_type round_capacity(size_type capacity){
+        if (!PowerOfTwo) return capacity;
+        size_type rounded = 1;
+        while (rounded < capacity){
+            if (rounded > std::numeric_limits<size_type>::max() / 2) throw std::length_error("dynamic_ring_buffer: capacity too large");
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+    size_type end_index() const { return wrap(start_ + count_); }
+
+    void advance_end(){
+        if (count_ == capacity_) start_ = wrap(start_ + 1);
+        else count_++;
+    }
+
+    void destroy_front(size_type n){
+        for (size_type i = 0; i < n; ++i) allocator_traits::destroy(allocator_, data_ + wrap(start_ + i));
+    }
+
+    void release(){
+        if (data_ == nullptr) return;
+        destroy_front(count_);
+        allocator_traits::deallocate(allocator_, data_, capacity_);
+        data_ = nullptr;
+    }
+};
+
+template<typename T_, bool PowerOfTwo_, class Allocator_> std::ostream& operator<<(std::ostream& out,
+								const dynamic_ring_buffer<T_, PowerOfTwo_, Allocator_>& ring) {
+	out << "dynamic_ring_buffer<" << ring.max_size() << "> {";
+	if (!ring.empty()) {
+        using size_type = typename dynamic_ring_buffer<T_, PowerOfTwo_, Allocator_>::size_type;
+        for (size_type i = 0; i < ring.max_size(); ++i){
+            if (ring.valid_index(i)) out << ring[i];
+            else out << "_";
+            if (i != ring.max_size() - 1) out << ", ";
+        }
+	}
+	return out << "}";
+}
+
 } // namespace
 
 #endif
@@ -0,0 +1,75 @@
+// Read from and write to file descriptors directly through a byte ring_buffer's storage.
+// Each call is a single readv or writev over the ring's (at most two) contiguous segments,
+// so data moves between the kernel and the ring without an intermediate buffer.
+// The functions follow the POSIX calls: they return the number of bytes transferred, or -1
+// and set errno on failure. Interrupted calls are retried.
+// Note: POSIX only (uses sys/uio.h)
+
+#ifndef BSP_RING_BUFFER_IO_H
+#define BSP_RING_BUFFER_IO_H
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cerrno>
+#include <cstddef>
+#include <type_traits>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "ring_buffer.h"
+
+namespace bsp {
+
+namespace detail_ring_buffer_io {
+// Fills iov with the non-empty segments, returns how many were used
+template<typename Segments> int to_iovec(const Segments& segments, struct iovec (&iov)[2]) {
+	int n = 0;
+	for (const auto& s : segments) {
+		if (s.empty()) continue;
+		iov[n].iov_base = const_cast<void*>(static_cast<const void*>(s.data()));
+		iov[n].iov_len = static_cast<std::size_t>(s.size());
+		n++;
+	}
+	return n;
+}
+} // namespace detail_ring_buffer_io
+
+// Reads up to the ring's free space from fd and appends it to the ring
+// Returns 0 at end of file, or -1 with errno set to ENOBUFS if the ring is already full
+template<typename T, int Capacity, overflow_policy Policy> ssize_t read_from(int fd, ring_buffer<T, Capacity, Policy>& ring) {
+	static_assert(sizeof(T) == 1 && std::is_trivially_copyable<T>::value, "read_from requires a byte ring_buffer");
+	struct iovec iov[2];
+	const int iovcnt = detail_ring_buffer_io::to_iovec(ring.write_segments(), iov);
+	if (iovcnt == 0) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	ssize_t n;
+	do {
+		n = readv(fd, iov, iovcnt);
+	} while (n == -1 && errno == EINTR);
+	if (n > 0) ring.commit_push_back(static_cast<int>(n));
+	return n;
+}
+
+// Writes as much of the ring's contents to fd as it accepts and pops what was written
+// Returns 0 without writing if the ring is empty
+template<typename T, int Capacity, overflow_policy Policy> ssize_t write_to(int fd, ring_buffer<T, Capacity, Policy>& ring) {
+	static_assert(sizeof(T) == 1 && std::is_trivially_copyable<T>::value, "write_to requires a byte ring_buffer");
+	struct iovec iov[2];
+	const int iovcnt = detail_ring_buffer_io::to_iovec(ring.read_segments(), iov);
+	if (iovcnt == 0) return 0;
+	ssize_t n;
+	do {
+		n = writev(fd, iov, iovcnt);
+	} while (n == -1 && errno == EINTR);
+	if (n > 0) ring.pop_front_n(static_cast<int>(n));
+	return n;
+}
+
+} // namespace bsp
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif
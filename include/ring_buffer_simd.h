@@ -0,0 +1,243 @@
+// Vectorised reductions (ring_sum, ring_min, ring_max, ring_dot) over the contents of a
+// ring_buffer<float, N>. The ring_ prefix keeps them clear of std::min/std::max and other
+// unqualified sum/dot overloads found by argument-dependent lookup.
+// Each reduction runs a contiguous kernel over the ring's two read_segments() instead of
+// iterating element by element, and the kernel is picked at compile time from the target:
+// AVX (8 floats, with FMA for dot if available), SSE (4 floats) or a scalar fallback.
+// Customise the behaviour by defining these before including it:
+// #define BSP_RING_BUFFER_SIMD_SCALAR to always use the scalar kernels
+// Note: Sums are accumulated in several lanes, so results can differ from a sequential
+// loop in the last bits. min and max ignore NaN handling.
+
+#ifndef BSP_RING_BUFFER_SIMD_H
+#define BSP_RING_BUFFER_SIMD_H
+
+#include <algorithm>
+#include <cassert>
+
+#include "ring_buffer.h"
+
+#if !defined(BSP_RING_BUFFER_SIMD_SCALAR)
+#if defined(__AVX__)
+#define BSP_RING_BUFFER_SIMD_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BSP_RING_BUFFER_SIMD_SSE 1
+#include <xmmintrin.h>
+#endif
+#endif
+
+namespace bsp {
+
+namespace detail_ring_buffer_simd {
+
+// Scalar kernels, always available, four independent accumulators to break the dependency chain
+inline float scalar_sum(const float* data, int n) {
+	float a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		a0 += data[i];
+		a1 += data[i + 1];
+		a2 += data[i + 2];
+		a3 += data[i + 3];
+	}
+	for (; i < n; ++i) a0 += data[i];
+	return (a0 + a1) + (a2 + a3);
+}
+
+inline float scalar_min(const float* data, int n, float init) {
+	float a0 = init, a1 = init, a2 = init, a3 = init;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		a0 = std::min(a0, data[i]);
+		a1 = std::min(a1, data[i + 1]);
+		a2 = std::min(a2, data[i + 2]);
+		a3 = std::min(a3, data[i + 3]);
+	}
+	for (; i < n; ++i) a0 = std::min(a0, data[i]);
+	return std::min(std::min(a0, a1), std::min(a2, a3));
+}
+
+inline float scalar_max(const float* data, int n, float init) {
+	float a0 = init, a1 = init, a2 = init, a3 = init;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		a0 = std::max(a0, data[i]);
+		a1 = std::max(a1, data[i + 1]);
+		a2 = std::max(a2, data[i + 2]);
+		a3 = std::max(a3, data[i + 3]);
+	}
+	for (; i < n; ++i) a0 = std::max(a0, data[i]);
+	return std::max(std::max(a0, a1), std::max(a2, a3));
+}
+
+inline float scalar_dot(const float* a, const float* b, int n) {
+	float a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		a0 += a[i] * b[i];
+		a1 += a[i + 1] * b[i + 1];
+		a2 += a[i + 2] * b[i + 2];
+		a3 += a[i + 3] * b[i + 3];
+	}
+	for (; i < n; ++i) a0 += a[i] * b[i];
+	return (a0 + a1) + (a2 + a3);
+}
+
+#if defined(BSP_RING_BUFFER_SIMD_AVX)
+
+inline float horizontal_sum(__m256 v) {
+	__m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+	x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+	return _mm_cvtss_f32(x);
+}
+
+inline float simd_sum(const float* data, int n) {
+	__m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+	int i = 0;
+	for (; i + 16 <= n; i += 16) {
+		a0 = _mm256_add_ps(a0, _mm256_loadu_ps(data + i));
+		a1 = _mm256_add_ps(a1, _mm256_loadu_ps(data + i + 8));
+	}
+	for (; i + 8 <= n; i += 8) a0 = _mm256_add_ps(a0, _mm256_loadu_ps(data + i));
+	return horizontal_sum(_mm256_add_ps(a0, a1)) + scalar_sum(data + i, n - i);
+}
+
+inline float simd_min(const float* data, int n, float init) {
+	int i = 0;
+	if (n >= 8) {
+		__m256 m = _mm256_loadu_ps(data);
+		for (i = 8; i + 8 <= n; i += 8) m = _mm256_min_ps(m, _mm256_loadu_ps(data + i));
+		__m128 x = _mm_min_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+		x = _mm_min_ps(x, _mm_movehl_ps(x, x));
+		x = _mm_min_ss(x, _mm_shuffle_ps(x, x, 1));
+		init = std::min(init, _mm_cvtss_f32(x));
+	}
+	return scalar_min(data + i, n - i, init);
+}
+
+inline float simd_max(const float* data, int n, float init) {
+	int i = 0;
+	if (n >= 8) {
+		__m256 m = _mm256_loadu_ps(data);
+		for (i = 8; i + 8 <= n; i += 8) m = _mm256_max_ps(m, _mm256_loadu_ps(data + i));
+		__m128 x = _mm_max_ps(_mm256_castps256_ps128(m), _mm256_extractf128_ps(m, 1));
+		x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+		x = _mm_max_ss(x, _mm_shuffle_ps(x, x, 1));
+		init = std::max(init, _mm_cvtss_f32(x));
+	}
+	return scalar_max(data + i, n - i, init);
+}
+
+inline float simd_dot(const float* a, const float* b, int n) {
+	__m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+	int i = 0;
+	for (; i + 16 <= n; i += 16) {
+#if defined(__FMA__)
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), a1);
+#else
+		a0 = _mm256_add_ps(a0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+		a1 = _mm256_add_ps(a1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+#endif
+	}
+	return horizontal_sum(_mm256_add_ps(a0, a1)) + scalar_dot(a + i, b + i, n - i);
+}
+
+#elif defined(BSP_RING_BUFFER_SIMD_SSE)
+
+inline float horizontal_sum(__m128 x) {
+	x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+	x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 1));
+	return _mm_cvtss_f32(x);
+}
+
+inline float simd_sum(const float* data, int n) {
+	__m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		a0 = _mm_add_ps(a0, _mm_loadu_ps(data + i));
+		a1 = _mm_add_ps(a1, _mm_loadu_ps(data + i + 4));
+	}
+	return horizontal_sum(_mm_add_ps(a0, a1)) + scalar_sum(data + i, n - i);
+}
+
+inline float simd_min(const float* data, int n, float init) {
+	int i = 0;
+	if (n >= 4) {
+		__m128 m = _mm_loadu_ps(data);
+		for (i = 4; i + 4 <= n; i += 4) m = _mm_min_ps(m, _mm_loadu_ps(data + i));
+		m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+		m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+		init = std::min(init, _mm_cvtss_f32(m));
+	}
+	return scalar_min(data + i, n - i, init);
+}
+
+inline float simd_max(const float* data, int n, float init) {
+	int i = 0;
+	if (n >= 4) {
+		__m128 m = _mm_loadu_ps(data);
+		for (i = 4; i + 4 <= n; i += 4) m = _mm_max_ps(m, _mm_loadu_ps(data + i));
+		m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+		m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+		init = std::max(init, _mm_cvtss_f32(m));
+	}
+	return scalar_max(data + i, n - i, init);
+}
+
+inline float simd_dot(const float* a, const float* b, int n) {
+	__m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	return horizontal_sum(_mm_add_ps(a0, a1)) + scalar_dot(a + i, b + i, n - i);
+}
+
+#else
+
+inline float simd_sum(const float* data, int n) { return scalar_sum(data, n); }
+inline float simd_min(const float* data, int n, float init) { return scalar_min(data, n, init); }
+inline float simd_max(const float* data, int n, float init) { return scalar_max(data, n, init); }
+inline float simd_dot(const float* a, const float* b, int n) { return scalar_dot(a, b, n); }
+
+#endif
+
+} // namespace detail_ring_buffer_simd
+
+// Sum of the elements, 0 if empty
+template<int Capacity, overflow_policy Policy> float ring_sum(const ring_buffer<float, Capacity, Policy>& ring) {
+	const auto segments = ring.read_segments();
+	return detail_ring_buffer_simd::simd_sum(segments[0].data(), segments[0].size()) +
+		   detail_ring_buffer_simd::simd_sum(segments[1].data(), segments[1].size());
+}
+
+// Requires !ring.empty()
+template<int Capacity, overflow_policy Policy> float ring_min(const ring_buffer<float, Capacity, Policy>& ring) {
+	assert(!ring.empty());
+	const auto segments = ring.read_segments();
+	const float first = detail_ring_buffer_simd::simd_min(segments[0].data(), segments[0].size(), ring.front());
+	return detail_ring_buffer_simd::simd_min(segments[1].data(), segments[1].size(), first);
+}
+
+template<int Capacity, overflow_policy Policy> float ring_max(const ring_buffer<float, Capacity, Policy>& ring) {
+	assert(!ring.empty());
+	const auto segments = ring.read_segments();
+	const float first = detail_ring_buffer_simd::simd_max(segments[0].data(), segments[0].size(), ring.front());
+	return detail_ring_buffer_simd::simd_max(segments[1].data(), segments[1].size(), first);
+}
+
+// Dot product of the elements, in order from the front, with weights[0, ring.count())
+template<int Capacity, overflow_policy Policy>
+float ring_dot(const ring_buffer<float, Capacity, Policy>& ring, const float* weights) {
+	const auto segments = ring.read_segments();
+	return detail_ring_buffer_simd::simd_dot(segments[0].data(), weights, segments[0].size()) +
+		   detail_ring_buffer_simd::simd_dot(segments[1].data(), weights + segments[0].size(), segments[1].size());
+}
+
+} // namespace bsp
+
+#endif
@@ -0,0 +1,156 @@
+// Aggregates over the last Capacity samples of a stream, updated in O(1) amortised per sample.
+// Tracks the running sum and mean, the variance (Welford's method, with removal of the
+// sample leaving the window) and the min and max (monotonic deques).
+
+#ifndef BSP_SLIDING_WINDOW_H
+#define BSP_SLIDING_WINDOW_H
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+
+#include "ring_buffer.h"
+
+namespace bsp {
+
+template<typename T, int Capacity, typename Accumulator = double> class sliding_window {
+	static_assert(Capacity > 0, "Capacity <= 0!");
+
+public:
+	using value_type = T;
+	using const_reference = const T&;
+	using size_type = int;
+	using accumulator_type = Accumulator;
+	using samples_type = ring_buffer<T, Capacity>;
+
+public:
+	sliding_window() = default;
+
+	size_type count() const { return samples_.count(); }
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	bool empty() const { return samples_.empty(); }
+
+	bool full() const { return count() == max_size(); }
+
+	void clear() {
+		samples_.clear();
+		max_deque_.clear();
+		min_deque_.clear();
+		sum_ = mean_ = m2_ = Accumulator(0);
+		sequence_ = 0;
+	}
+
+	// Add a sample, evicting the oldest one if the window is full
+	void push(const T& value) {
+		if (full()) {
+			remove_oldest(samples_.front());
+		}
+		samples_.push_back(value);
+		add_newest(value);
+	}
+
+	// Add n samples, only the last max_size() of them can be in the window
+	template<typename Iter> void push_n(Iter first, size_type n) {
+		assert(n >= 0);
+		if (n >= max_size()) {
+			clear();
+			std::advance(first, n - max_size());
+			n = max_size();
+		}
+		for (size_type i = 0; i < n; ++i, ++first) push(*first);
+	}
+
+	Accumulator sum() const { return sum_; }
+
+	Accumulator mean() const { return mean_; }
+
+	// Population variance of the window
+	Accumulator variance() const { return count() > 0 ? clamp_positive(m2_ / count()) : Accumulator(0); }
+
+	// Sample variance of the window (Bessel's correction)
+	Accumulator sample_variance() const { return count() > 1 ? clamp_positive(m2_ / (count() - 1)) : Accumulator(0); }
+
+	Accumulator stddev() const { return std::sqrt(variance()); }
+
+	// Requires !empty()
+	const_reference min() const {
+		assert(!empty());
+		return min_deque_.front().value;
+	}
+
+	const_reference max() const {
+		assert(!empty());
+		return max_deque_.front().value;
+	}
+
+	const samples_type& samples() const { return samples_; }
+
+protected:
+	struct entry {
+		std::uint64_t sequence;
+		T value;
+	};
+
+	samples_type samples_;
+	ring_buffer<entry, Capacity> max_deque_; // Decreasing values, front is the max
+	ring_buffer<entry, Capacity> min_deque_; // Increasing values, front is the min
+	Accumulator sum_ = Accumulator(0);
+	Accumulator mean_ = Accumulator(0);
+	Accumulator m2_ = Accumulator(0);
+	std::uint64_t sequence_ = 0; // Sequence number of the next sample
+
+protected:
+	void add_newest(const T& value) {
+		const Accumulator x = static_cast<Accumulator>(value);
+		sum_ += x;
+		const Accumulator delta = x - mean_;
+		mean_ += delta / count();
+		m2_ += delta * (x - mean_);
+
+		// Samples older than the window were evicted by remove_oldest
+		while (!max_deque_.empty() && !(value < max_deque_.back().value)) max_deque_.pop_back();
+		max_deque_.push_back(entry { sequence_, value });
+		while (!min_deque_.empty() && !(min_deque_.back().value < value)) min_deque_.pop_back();
+		min_deque_.push_back(entry { sequence_, value });
+		sequence_++;
+	}
+
+	void remove_oldest(const T& value) {
+		const Accumulator x = static_cast<Accumulator>(value);
+		const size_type remaining = count() - 1;
+		sum_ -= x;
+		if (remaining == 0) {
+			mean_ = m2_ = Accumulator(0);
+		}
+		else {
+			const Accumulator delta = x - mean_;
+			mean_ -= delta / remaining;
+			m2_ -= delta * (x - mean_);
+		}
+
+		const std::uint64_t oldest = sequence_ - static_cast<std::uint64_t>(count());
+		if (max_deque_.front().sequence == oldest) max_deque_.pop_front();
+		if (min_deque_.front().sequence == oldest) min_deque_.pop_front();
+	}
+
+	// Rounding can leave m2_ slightly negative when the window is (nearly) constant
+	static Accumulator clamp_positive(Accumulator value) { return value < Accumulator(0) ? Accumulator(0) : value; }
+};
+
+template<typename T_, int Capacity_, typename Accumulator_>
+std::ostream& operator<<(std::ostream& out, const sliding_window<T_, Capacity_, Accumulator_>& window) {
+	out << "sliding_window<" << Capacity_ << "> {count: " << window.count();
+	if (!window.empty()) {
+		out << ", mean: " << window.mean() << ", variance: " << window.variance()
+			<< ", min: " << window.min() << ", max: " << window.max();
+	}
+	return out << "}";
+}
+
+} // namespace bsp
+
+#endif
@@ -0,0 +1,255 @@
+// A ring buffer of timestamped samples, for keeping the most recent window of a stream.
+// Timestamps and values are stored in separate arrays so searches only touch timestamps.
+// Timestamps must be pushed in non-decreasing order, which keeps the logical sequence
+// sorted and allows binary search across the wrap point.
+// Values live in uninitialised storage, as in ring_buffer, so T need not be default constructible.
+
+#ifndef BSP_TIME_SERIES_RING_H
+#define BSP_TIME_SERIES_RING_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#include "ring_buffer.h"
+
+namespace bsp {
+
+template<typename T, int Capacity, typename Timestamp = std::int64_t>
+class time_series_ring : public detail_ring_buffer::ring_cursors<Capacity> {
+	static_assert(Capacity > 0, "Capacity <= 0!");
+	static_assert(std::is_arithmetic<Timestamp>::value, "time_series_ring: Timestamp must be arithmetic");
+	using cursors = detail_ring_buffer::ring_cursors<Capacity>;
+
+public:
+	using value_type = T;
+	using const_reference = const T&;
+	using timestamp_type = Timestamp;
+	using size_type = int;
+	using const_value_span = detail_ring_buffer::ring_span<const T>;
+	using const_time_span = detail_ring_buffer::ring_span<const Timestamp>;
+	using const_value_segments = std::array<const_value_span, 2>;
+	using const_time_segments = std::array<const_time_span, 2>;
+
+	// Positions [first, last) relative to the front
+	struct index_range {
+		size_type first;
+		size_type last;
+
+		size_type size() const { return last - first; }
+		bool empty() const { return first == last; }
+	};
+
+public:
+	time_series_ring() = default;
+
+	time_series_ring(const time_series_ring& other) : cursors(other), times_(other.times_) {
+		for (size_type i = 0; i < count(); ++i) new (value_data() + slot(i)) T(other.value(i));
+	}
+
+	time_series_ring(time_series_ring&& other) : cursors(other), times_(other.times_) {
+		for (size_type i = 0; i < count(); ++i) new (value_data() + slot(i)) T(std::move(other.value_data()[slot(i)]));
+	}
+
+	time_series_ring& operator=(const time_series_ring& other) {
+		if (this == &other) return *this;
+		clear();
+		cursors::operator=(other);
+		times_ = other.times_;
+		for (size_type i = 0; i < count(); ++i) new (value_data() + slot(i)) T(other.value(i));
+		return *this;
+	}
+
+	time_series_ring& operator=(time_series_ring&& other) {
+		if (this == &other) return *this;
+		clear();
+		cursors::operator=(other);
+		times_ = other.times_;
+		for (size_type i = 0; i < count(); ++i) new (value_data() + slot(i)) T(std::move(other.value_data()[slot(i)]));
+		return *this;
+	}
+
+	~time_series_ring() { destroy_front(count()); }
+
+	using cursors::count;
+	using cursors::start;
+
+	static constexpr inline size_type max_size() { return Capacity; }
+
+	bool empty() const { return count() == 0; }
+
+	bool full() const { return count() == max_size(); }
+
+	void clear() {
+		destroy_front(count());
+		cursors::reset();
+	}
+
+	// Append a sample, overwriting the oldest one when full
+	// Requires time >= back_time()
+	void push_back(Timestamp time, const T& value) {
+		assert(empty() || !(time < back_time()));
+		const size_type index = cursors::end_index();
+		times_[index] = time;
+		if (full()) {
+			value_data()[index] = value;
+			cursors::advance_end_full();
+		}
+		else {
+			new (value_data() + index) T(value);
+			cursors::advance_end_not_full();
+		}
+	}
+
+	void pop_front() {
+		assert(!empty());
+		value_data()[start()].~T();
+		cursors::advance_start();
+	}
+
+	void pop_front_n(size_type n) {
+		assert(n >= 0 && n <= count());
+		destroy_front(n);
+		cursors::advance_start_n(n);
+	}
+
+	// Drop every sample older than time in one step, returns the number dropped
+	size_type expire_before(Timestamp time) {
+		const size_type n = lower_bound(time);
+		pop_front_n(n);
+		return n;
+	}
+
+	// Drop every sample more than max_age older than now
+	size_type expire_older_than(Timestamp now, Timestamp max_age) { return expire_before(now - max_age); }
+
+	// Relative to the front, requires position < count()
+	Timestamp time(size_type position) const { return times_[slot(position)]; }
+	const_reference value(size_type position) const { return value_data()[slot(position)]; }
+
+	Timestamp front_time() const { return times_[start()]; }
+	Timestamp back_time() const { return time(count() - 1); }
+	const_reference front() const { return value_data()[start()]; }
+	const_reference back() const { return value(count() - 1); }
+
+	// Position of the first sample with a timestamp >= time, or count() if there is none
+	size_type lower_bound(Timestamp time) const {
+		return search(time, [](Timestamp a, Timestamp b) { return a < b; });
+	}
+
+	// Position of the first sample with a timestamp > time, or count() if there is none
+	size_type upper_bound(Timestamp time) const {
+		return search(time, [](Timestamp a, Timestamp b) { return !(b < a); });
+	}
+
+	// The samples with from <= timestamp < to
+	index_range range(Timestamp from, Timestamp to) const {
+		const size_type first = lower_bound(from);
+		return index_range { first, std::max(first, lower_bound(to)) };
+	}
+
+	// The timestamps and values of a range as at most two contiguous spans each
+	const_time_segments time_segments(index_range r) const { return make_segments(times_.data(), r); }
+	const_value_segments value_segments(index_range r) const { return make_segments(value_data(), r); }
+
+	const_time_segments time_segments() const { return time_segments(index_range { 0, count() }); }
+	const_value_segments value_segments() const { return value_segments(index_range { 0, count() }); }
+
+	// Downsampling reader: splits [from, to) into buckets of width and calls
+	// fn(bucket_start, const_value_segments) for every bucket that holds samples.
+	// The values are read in place, nothing is copied. Each bucket costs one binary search.
+	template<typename Fn> void for_each_bucket(Timestamp from, Timestamp to, Timestamp width, Fn fn) const {
+		assert(width > Timestamp(0));
+		const size_type end = lower_bound(to);
+		size_type first = lower_bound(from);
+		while (first < end) {
+			// Skip empty buckets by starting from the bucket the next sample falls into
+			// Floating point division can land a bucket off, so step until the bucket holds time(first),
+			// which guarantees at least one sample per call (the loops never run for integers)
+			const Timestamp t = time(first);
+			Timestamp bucket = bucket_of(t - from, width);
+			while (t < from + bucket * width) bucket -= 1;
+			while (!(t < from + (bucket + 1) * width)) bucket += 1;
+			const Timestamp bucket_start = from + bucket * width;
+			const Timestamp bucket_end = from + (bucket + 1) * width;
+			const size_type last = std::min(end, lower_bound_from(first, bucket_end));
+			fn(bucket_start, value_segments(index_range { first, last }));
+			first = last;
+		}
+	}
+
+protected:
+	using raw_type = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+	std::array<Timestamp, Capacity> times_ {};
+	raw_type values_[Capacity]; // Only the slots of the count() samples from start() are constructed
+
+protected:
+	T* value_data() { return reinterpret_cast<T*>(values_); }
+	const T* value_data() const { return reinterpret_cast<const T*>(values_); }
+
+	void destroy_front(size_type n) {
+		for (size_type i = 0; i < n; ++i) value_data()[slot(i)].~T();
+	}
+
+	size_type slot(size_type position) const { return cursors::wrap(start() + position); }
+
+	// The sorted sequence is times_[start(), max_size()) followed by times_[0, end)
+	template<typename Less> size_type search(Timestamp time, Less less) const {
+		const size_type first_run = std::min(count(), max_size() - start());
+		const Timestamp* begin = times_.data() + start();
+		if (first_run > 0 && !less(begin[first_run - 1], time)) {
+			return static_cast<size_type>(std::lower_bound(begin, begin + first_run, time, less) - begin);
+		}
+		const Timestamp* wrapped = times_.data();
+		return first_run +
+			   static_cast<size_type>(std::lower_bound(wrapped, wrapped + (count() - first_run), time, less) - wrapped);
+	}
+
+	// lower_bound over positions [first, count())
+	size_type lower_bound_from(size_type first, Timestamp time) const {
+		size_type n = count() - first;
+		while (n > 0) {
+			const size_type half = n / 2;
+			if (this->time(first + half) < time) {
+				first += half + 1;
+				n -= half + 1;
+			}
+			else
+				n = half;
+		}
+		return first;
+	}
+
+	static Timestamp bucket_of(Timestamp offset, Timestamp width) { return bucket_index(offset, width, std::is_integral<Timestamp>()); }
+	static Timestamp bucket_index(Timestamp offset, Timestamp width, std::true_type) { return offset / width; }
+	static Timestamp bucket_index(Timestamp offset, Timestamp width, std::false_type) { return std::floor(offset / width); }
+
+	template<typename U> std::array<detail_ring_buffer::ring_span<const U>, 2> make_segments(const U* data, index_range r) const {
+		using span = detail_ring_buffer::ring_span<const U>;
+		assert(r.first >= 0 && r.first <= r.last && r.last <= count());
+		const size_type first = slot(r.first);
+		const size_type first_run = std::min(r.size(), max_size() - first);
+		return std::array<span, 2> {{ span(data + first, first_run), span(data, r.size() - first_run) }};
+	}
+};
+
+template<typename T_, int Capacity_, typename Timestamp_>
+std::ostream& operator<<(std::ostream& out, const time_series_ring<T_, Capacity_, Timestamp_>& ring) {
+	out << "time_series_ring<" << Capacity_ << "> {";
+	for (int i = 0; i < ring.count(); ++i) {
+		if (i > 0) out << ", ";
+		out << ring.time(i) << ": " << ring.value(i);
+	}
+	return out << "}";
+}
+
+} // namespace bsp
+
+#endif
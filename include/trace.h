@@ -0,0 +1,227 @@
+// Low overhead tracing: every thread records begin/end/counter events into its own
+// spsc_ring_buffer without locks, and a collector drains all the rings and writes them as
+// Chrome trace_event JSON (load it in chrome://tracing or https://ui.perfetto.dev).
+// Event names are not copied, they must be string literals or otherwise outlive the trace.
+// When a thread's ring is full new events are dropped and counted, the hot path never waits.
+// Customise the behaviour by defining these before including it:
+// #define BSP_TRACE_ENABLED to turn the BSP_TRACE_* macros on, without it they compile to nothing
+// #define BSP_TRACE_RING_CAPACITY to change the number of events buffered per thread (default 4096)
+
+#ifndef BSP_TRACE_H
+#define BSP_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <vector>
+
+#include "concurrent_ring_buffer.h"
+
+#ifndef BSP_TRACE_RING_CAPACITY
+#define BSP_TRACE_RING_CAPACITY 4096
+#endif
+
+namespace bsp {
+
+struct trace_event {
+	enum phase_type : char { begin = 'B', end = 'E', counter = 'C' };
+
+	const char* name;
+	std::int64_t timestamp_ns;
+	std::int64_t value; // Counters only
+	phase_type phase;
+};
+
+class trace_collector {
+public:
+	// An event together with the thread that recorded it
+	struct record {
+		int thread_id;
+		trace_event event;
+	};
+
+	static trace_collector& instance() {
+		static trace_collector collector;
+		return collector;
+	}
+
+	static std::int64_t now_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Record an event on the calling thread's ring, never blocks
+	void record_event(trace_event::phase_type phase, const char* name, std::int64_t value = 0) {
+		thread_ring& ring = local_ring();
+		if (!ring.events.try_push(trace_event { name, now_ns(), value, phase })) {
+			ring.dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	// Name the calling thread in the trace
+	void set_thread_name(const char* name) { local_ring().name.store(name, std::memory_order_release); }
+
+	// Removes every buffered event from every thread's ring, in order per thread
+	// Rings of threads that have exited are released once they are drained
+	std::vector<record> drain() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::vector<record> records = drain_rings();
+		release_exited_rings();
+		return records;
+	}
+
+	// Events dropped because a thread's ring was full
+	std::size_t dropped() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::size_t total = retired_dropped_;
+		for (const auto& ring : rings_) total += ring->dropped.load(std::memory_order_relaxed);
+		return total;
+	}
+
+	// Drains every ring and writes the events as a Chrome trace_event JSON object
+	void write_chrome_trace(std::ostream& out) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		const std::vector<record> records = drain_rings();
+		out << "{\"traceEvents\":[";
+		bool first = true;
+		for (const auto& ring : rings_) {
+			const char* name = ring->name.load(std::memory_order_acquire);
+			if (name == nullptr) continue;
+			out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id
+				<< ",\"args\":{\"name\":";
+			write_string(out, name);
+			out << "}}";
+			first = false;
+		}
+		for (const record& r : records) {
+			out << (first ? "\n" : ",\n") << "{\"name\":";
+			write_string(out, r.event.name);
+			out << ",\"ph\":\"" << static_cast<char>(r.event.phase) << "\",\"ts\":" << r.event.timestamp_ns / 1000 << '.';
+			const std::int64_t fraction = r.event.timestamp_ns % 1000;
+			out << (fraction < 100 ? "0" : "") << (fraction < 10 ? "0" : "") << fraction;
+			out << ",\"pid\":1,\"tid\":" << r.thread_id;
+			if (r.event.phase == trace_event::counter) out << ",\"args\":{\"value\":" << r.event.value << "}";
+			out << "}";
+			first = false;
+		}
+		out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+		release_exited_rings();
+	}
+
+protected:
+	struct thread_ring {
+		int id;
+		std::atomic<const char*> name {nullptr};
+		std::atomic<std::size_t> dropped {0};
+		spsc_ring_buffer<trace_event, BSP_TRACE_RING_CAPACITY> events;
+
+		explicit thread_ring(int id_) : id(id_) {}
+
+		// The ring is cache line aligned, which plain new and make_shared only honour from C++17,
+		// so over-allocate and keep the original pointer just before the aligned block
+		static void* operator new(std::size_t size) {
+			const std::size_t alignment = alignof(thread_ring);
+			void* raw = ::operator new(size + alignment + sizeof(void*));
+			const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + alignment - 1) & ~(alignment - 1);
+			reinterpret_cast<void**>(aligned)[-1] = raw;
+			return reinterpret_cast<void*>(aligned);
+		}
+
+		static void operator delete(void* p) {
+			if (p) ::operator delete(static_cast<void**>(p)[-1]);
+		}
+	};
+
+	mutable std::mutex mutex_;
+	std::vector<std::shared_ptr<thread_ring>> rings_; // Kept after their thread exits until drained
+	std::size_t retired_dropped_ = 0;
+	int next_thread_id_ = 1;
+
+protected:
+	trace_collector() = default;
+
+	// Registers the calling thread's ring on its first event, later calls take no lock
+	thread_ring& local_ring() {
+		thread_local std::shared_ptr<thread_ring> ring = register_thread();
+		return *ring;
+	}
+
+	// Requires mutex_
+	std::vector<record> drain_rings() {
+		std::vector<record> records;
+		trace_event event;
+		for (const auto& ring : rings_) {
+			while (ring->events.try_pop(event)) records.push_back(record { ring->id, event });
+		}
+		return records;
+	}
+
+	// Requires mutex_, only the collector holds the ring of a thread that has exited
+	void release_exited_rings() {
+		for (auto it = rings_.begin(); it != rings_.end();) {
+			if (it->use_count() == 1 && (*it)->events.empty()) {
+				retired_dropped_ += (*it)->dropped.load(std::memory_order_relaxed);
+				it = rings_.erase(it);
+			}
+			else ++it;
+		}
+	}
+
+	std::shared_ptr<thread_ring> register_thread() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		rings_.push_back(std::shared_ptr<thread_ring>(new thread_ring(next_thread_id_++)));
+		return rings_.back();
+	}
+
+	static void write_string(std::ostream& out, const char* s) {
+		static const char hex[] = "0123456789abcdef";
+		out << '"';
+		for (; *s; ++s) {
+			const unsigned char c = static_cast<unsigned char>(*s);
+			if (c == '"' || c == '\\') out << '\\' << *s;
+			else if (c < 0x20) out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+			else out << *s;
+		}
+		out << '"';
+	}
+};
+
+// Records a begin event now and the matching end event when it goes out of scope
+class trace_zone {
+public:
+	explicit trace_zone(const char* name) : name_(name) { trace_collector::instance().record_event(trace_event::begin, name_); }
+
+	trace_zone(const trace_zone&) = delete;
+	trace_zone& operator=(const trace_zone&) = delete;
+
+	~trace_zone() { trace_collector::instance().record_event(trace_event::end, name_); }
+
+protected:
+	const char* name_;
+};
+
+} // namespace bsp
+
+#define BSP_TRACE_CONCAT_(a, b) a##b
+#define BSP_TRACE_CONCAT(a, b) BSP_TRACE_CONCAT_(a, b)
+
+#if defined(BSP_TRACE_ENABLED)
+#define BSP_TRACE_ZONE(name) ::bsp::trace_zone BSP_TRACE_CONCAT(bsp_trace_zone_, __LINE__)(name)
+#define BSP_TRACE_BEGIN(name) ::bsp::trace_collector::instance().record_event(::bsp::trace_event::begin, name)
+#define BSP_TRACE_END(name) ::bsp::trace_collector::instance().record_event(::bsp::trace_event::end, name)
+#define BSP_TRACE_COUNTER(name, value) \
+	::bsp::trace_collector::instance().record_event(::bsp::trace_event::counter, name, static_cast<std::int64_t>(value))
+#define BSP_TRACE_THREAD_NAME(name) ::bsp::trace_collector::instance().set_thread_name(name)
+#else
+#define BSP_TRACE_ZONE(name) ((void) 0)
+#define BSP_TRACE_BEGIN(name) ((void) 0)
+#define BSP_TRACE_END(name) ((void) 0)
+#define BSP_TRACE_COUNTER(name, value) ((void) 0)
+#define BSP_TRACE_THREAD_NAME(name) ((void) 0)
+#endif
+
+#endif
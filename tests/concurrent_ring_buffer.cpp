@@ -0,0 +1,706 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "../include/concurrent_ring_buffer.h"
+#include "../include/ring_buffer.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+using bsp::blocking_ring_buffer;
+using bsp::broadcast_policy;
+using bsp::broadcast_ring_buffer;
+using bsp::mpmc_ring_buffer;
+using bsp::spsc_ring_buffer;
+using Catch::Equals;
+
+// Pins the calling thread to a cpu (if supported), so benchmarks measure cross-core traffic
+static void pin_this_thread(int cpu) {
+#if defined(__linux__)
+	const int num_cpus = std::max(1, (int) std::thread::hardware_concurrency());
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu % num_cpus, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void) cpu;
+#endif
+}
+
+// Pins the calling thread for its lifetime and then restores the affinity it had, for benchmarks
+// that pin the Catch main thread, which goes on to run the rest of the suite
+class scoped_pin {
+public:
+	explicit scoped_pin(int cpu) {
+#if defined(__linux__)
+		saved_ = pthread_getaffinity_np(pthread_self(), sizeof(saved_set_), &saved_set_) == 0;
+#endif
+		pin_this_thread(cpu);
+	}
+
+	~scoped_pin() {
+#if defined(__linux__)
+		if (saved_) pthread_setaffinity_np(pthread_self(), sizeof(saved_set_), &saved_set_);
+#endif
+	}
+
+	scoped_pin(const scoped_pin&) = delete;
+	scoped_pin& operator=(const scoped_pin&) = delete;
+
+protected:
+#if defined(__linux__)
+	cpu_set_t saved_set_;
+	bool saved_ = false;
+#endif
+};
+
+TEST_CASE("spsc_ring_buffer basics", "[spsc_ring_buffer]") {
+	spsc_ring_buffer<int, 4> ring;
+	CHECK(ring.empty());
+	CHECK(ring.max_size() == 4);
+
+	int value = 0;
+	CHECK(!ring.try_pop(value));
+
+	SECTION("push and pop") {
+		CHECK(ring.try_push(1));
+		CHECK(ring.try_push(2));
+		CHECK(ring.count() == 2);
+		CHECK(ring.try_pop(value));
+		CHECK(value == 1);
+		CHECK(ring.try_pop(value));
+		CHECK(value == 2);
+		CHECK(ring.empty());
+	}
+
+	SECTION("rejects when full") {
+		for (int i = 0; i < 4; ++i) CHECK(ring.try_push(i));
+		CHECK(!ring.try_push(4));
+		CHECK(ring.try_pop(value));
+		CHECK(value == 0);
+		CHECK(ring.try_push(4));
+		std::vector<int> values;
+		while (ring.try_pop(value)) values.push_back(value);
+		CHECK_THAT(values, Equals(std::vector<int>{ 1, 2, 3, 4 }));
+	}
+
+	SECTION("wraps around") {
+		for (int i = 0; i < 100; ++i) {
+			CHECK(ring.try_push(i));
+			CHECK(ring.try_pop(value));
+			CHECK(value == i);
+		}
+	}
+
+	SECTION("try_front") {
+		ring.try_push(42);
+		REQUIRE(ring.try_front() != nullptr);
+		CHECK(*ring.try_front() == 42);
+		ring.pop_front();
+		CHECK(ring.try_front() == nullptr);
+	}
+}
+
+TEST_CASE("spsc_ring_buffer non-trivial types", "[spsc_ring_buffer]") {
+	SECTION("move only") {
+		spsc_ring_buffer<std::unique_ptr<int>, 4> ring;
+		CHECK(ring.try_emplace(new int(42)));
+		std::unique_ptr<int> value;
+		CHECK(ring.try_pop(value));
+		CHECK(*value == 42);
+	}
+
+	SECTION("destroys remaining elements") {
+		auto counter = std::make_shared<int>(0);
+		{
+			spsc_ring_buffer<std::shared_ptr<int>, 4> ring;
+			ring.try_push(counter);
+			ring.try_push(counter);
+			CHECK(counter.use_count() == 3);
+		}
+		CHECK(counter.use_count() == 1);
+	}
+}
+
+TEST_CASE("spsc_ring_buffer threads", "[spsc_ring_buffer]") {
+	spsc_ring_buffer<int, 64> ring;
+	const int num_values = 100000;
+	long long sum = 0;
+	bool in_order = true;
+
+	std::thread consumer([&]() {
+		int expected = 0;
+		int value = 0;
+		while (expected < num_values) {
+			if (ring.try_pop(value)) {
+				in_order = in_order && value == expected;
+				sum += value;
+				expected++;
+			}
+			else std::this_thread::yield();
+		}
+	});
+
+	for (int i = 0; i < num_values; ++i) {
+		while (!ring.try_push(i)) std::this_thread::yield();
+	}
+	consumer.join();
+
+	CHECK(in_order);
+	CHECK(sum == (long long) num_values * (num_values - 1) / 2);
+	CHECK(ring.empty());
+}
+
+TEST_CASE("spsc_ring_buffer (benchmarks)", "[!benchmark][spsc_ring_buffer]") {
+	static const int num_values = 1 << 20;
+	static const int num_round_trips = 1 << 16;
+
+	BENCHMARK("throughput: spsc_ring_buffer (1M ints)") {
+		spsc_ring_buffer<int, 1024> ring;
+		std::thread consumer([&]() {
+			pin_this_thread(1);
+			int value = 0;
+			for (int i = 0; i < num_values; ++i) {
+				while (!ring.try_pop(value)) std::this_thread::yield();
+			}
+		});
+		scoped_pin pin(0);
+		for (int i = 0; i < num_values; ++i) {
+			while (!ring.try_push(i)) std::this_thread::yield();
+		}
+		consumer.join();
+	}
+
+	BENCHMARK("throughput: ring_buffer + std::mutex (1M ints)") {
+		bsp::ring_buffer<int, 1024> ring;
+		std::mutex mutex;
+		std::thread consumer([&]() {
+			pin_this_thread(1);
+			for (int i = 0; i < num_values;) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!ring.empty()) {
+					ring.pop_front();
+					++i;
+				}
+			}
+		});
+		scoped_pin pin(0);
+		for (int i = 0; i < num_values;) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (ring.count() < ring.max_size()) {
+				ring.push_back(i);
+				++i;
+			}
+		}
+		consumer.join();
+	}
+
+	BENCHMARK("latency: spsc_ring_buffer (64k round trips)") {
+		spsc_ring_buffer<int, 16> ping;
+		spsc_ring_buffer<int, 16> pong;
+		std::thread echo([&]() {
+			pin_this_thread(1);
+			int value = 0;
+			for (int i = 0; i < num_round_trips; ++i) {
+				while (!ping.try_pop(value)) std::this_thread::yield();
+				pong.try_push(value);
+			}
+		});
+		scoped_pin pin(0);
+		int value = 0;
+		for (int i = 0; i < num_round_trips; ++i) {
+			ping.try_push(i);
+			while (!pong.try_pop(value)) std::this_thread::yield();
+		}
+		echo.join();
+	}
+}
+
+TEST_CASE("mpmc_ring_buffer basics", "[mpmc_ring_buffer]") {
+	mpmc_ring_buffer<int, 3> ring;
+	CHECK(ring.empty());
+	CHECK(ring.max_size() == 3);
+
+	int value = 0;
+	CHECK(!ring.try_pop(value));
+
+	SECTION("rejects when full") {
+		for (int i = 0; i < 3; ++i) CHECK(ring.try_push(i));
+		CHECK(ring.count() == 3);
+		CHECK(!ring.try_push(3));
+		CHECK(ring.try_pop(value));
+		CHECK(value == 0);
+		CHECK(ring.try_push(3));
+		std::vector<int> values;
+		while (ring.try_pop(value)) values.push_back(value);
+		CHECK_THAT(values, Equals(std::vector<int>{ 1, 2, 3 }));
+	}
+
+	SECTION("wraps around") {
+		for (int i = 0; i < 100; ++i) {
+			CHECK(ring.try_push(i));
+			CHECK(ring.try_pop(value));
+			CHECK(value == i);
+		}
+		CHECK(ring.empty());
+	}
+
+	SECTION("smallest capacity") {
+		mpmc_ring_buffer<int, 2> small;
+		for (int lap = 0; lap < 5; ++lap) {
+			CHECK(small.try_push(2 * lap));
+			CHECK(small.try_push(2 * lap + 1));
+			CHECK(!small.try_push(-1));
+			CHECK(small.count() == 2);
+			CHECK(small.try_pop(value));
+			CHECK(value == 2 * lap);
+			CHECK(small.try_pop(value));
+			CHECK(value == 2 * lap + 1);
+			CHECK(!small.try_pop(value));
+		}
+	}
+
+	SECTION("destroys remaining elements") {
+		auto counter = std::make_shared<int>(0);
+		{
+			mpmc_ring_buffer<std::shared_ptr<int>, 4> shared_ring;
+			shared_ring.try_push(counter);
+			shared_ring.try_push(counter);
+			CHECK(counter.use_count() == 3);
+		}
+		CHECK(counter.use_count() == 1);
+	}
+}
+
+// Pushes [0, num_values) split across producers and checks consumers see each value once
+template<int Capacity>
+static void run_mpmc(mpmc_ring_buffer<int, Capacity>& ring, int num_producers, int num_consumers, int num_values, std::vector<int>* seen) {
+	std::atomic<int> consumed {0};
+	std::vector<std::thread> threads;
+	for (int p = 0; p < num_producers; ++p) {
+		threads.emplace_back([&, p]() {
+			pin_this_thread(p);
+			for (int i = p; i < num_values; i += num_producers) {
+				while (!ring.try_push(i)) std::this_thread::yield();
+			}
+		});
+	}
+	for (int c = 0; c < num_consumers; ++c) {
+		threads.emplace_back([&, c]() {
+			pin_this_thread(num_producers + c);
+			int value = 0;
+			while (consumed.load() < num_values) {
+				if (ring.try_pop(value)) {
+					if (seen) (*seen)[value]++; // Distinct indices per value, so no race
+					consumed++;
+				}
+				else std::this_thread::yield();
+			}
+		});
+	}
+	for (auto& t : threads) t.join();
+}
+
+TEST_CASE("mpmc_ring_buffer threads", "[mpmc_ring_buffer]") {
+	const int num_values = 40000;
+	mpmc_ring_buffer<int, 64> ring;
+	std::vector<int> seen(num_values, 0);
+	run_mpmc(ring, 4, 4, num_values, &seen);
+	CHECK(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }));
+	CHECK(ring.empty());
+}
+
+TEST_CASE("mpmc_ring_buffer (benchmarks)", "[!benchmark][mpmc_ring_buffer]") {
+	static const int num_values = 1 << 18;
+
+	BENCHMARK("contention: 1 producer x 1 consumer") {
+		mpmc_ring_buffer<int, 1024> ring;
+		run_mpmc(ring, 1, 1, num_values, nullptr);
+	}
+
+	BENCHMARK("contention: 2 producers x 2 consumers") {
+		mpmc_ring_buffer<int, 1024> ring;
+		run_mpmc(ring, 2, 2, num_values, nullptr);
+	}
+
+	BENCHMARK("contention: 4 producers x 4 consumers") {
+		mpmc_ring_buffer<int, 1024> ring;
+		run_mpmc(ring, 4, 4, num_values, nullptr);
+	}
+
+	BENCHMARK("contention: 8 producers x 8 consumers") {
+		mpmc_ring_buffer<int, 1024> ring;
+		run_mpmc(ring, 8, 8, num_values, nullptr);
+	}
+}
+
+TEST_CASE("broadcast_ring_buffer basics", "[broadcast_ring_buffer]") {
+	broadcast_ring_buffer<int, 4, 2> ring;
+	CHECK(ring.max_size() == 4);
+	CHECK(ring.consumers() == 2);
+	CHECK(ring.empty(0));
+	CHECK(ring.try_front(0) == nullptr);
+
+	SECTION("every consumer sees every event") {
+		for (int i = 0; i < 3; ++i) CHECK(ring.try_push(i));
+		CHECK(ring.count(0) == 3);
+		CHECK(ring.count(1) == 3);
+
+		int value = 0;
+		CHECK(ring.try_pop(0, value));
+		CHECK(value == 0);
+		REQUIRE(ring.try_front(1) != nullptr);
+		CHECK(*ring.try_front(1) == 0);
+		CHECK(ring.try_front(1) == ring.try_front(1)); // Read in place
+
+		std::vector<int> values;
+		CHECK(ring.consume(1, [&](const int& v) { values.push_back(v); }) == 3);
+		CHECK_THAT(values, Equals(std::vector<int>{ 0, 1, 2 }));
+		CHECK(ring.empty(1));
+		CHECK(ring.count(0) == 2);
+	}
+
+	SECTION("backpressure on the slowest consumer") {
+		for (int i = 0; i < 4; ++i) CHECK(ring.try_push(i));
+		CHECK(!ring.try_push(4));
+		CHECK(ring.consume(0, [](const int&) {}) == 4);
+		CHECK(!ring.try_push(4)); // Consumer 1 hasn't read anything
+		ring.pop_front(1);
+		CHECK(ring.try_push(4));
+		CHECK(!ring.try_push(5));
+
+		std::vector<int> values;
+		ring.consume(1, [&](const int& v) { values.push_back(v); }, 2);
+		CHECK_THAT(values, Equals(std::vector<int>{ 1, 2 }));
+		ring.consume(0, [&](const int& v) { values.push_back(v); });
+		CHECK_THAT(values, Equals(std::vector<int>{ 1, 2, 4 }));
+	}
+
+	SECTION("destroys remaining events") {
+		auto counter = std::make_shared<int>(0);
+		{
+			broadcast_ring_buffer<std::shared_ptr<int>, 2, 3> shared_ring;
+			for (int i = 0; i < 2; ++i) shared_ring.try_push(counter);
+			for (int c = 0; c < 3; ++c) shared_ring.consume(c, [](const std::shared_ptr<int>&) {});
+			shared_ring.try_push(counter); // Destroys the oldest
+			CHECK(counter.use_count() == 3);
+		}
+		CHECK(counter.use_count() == 1);
+	}
+}
+
+TEST_CASE("broadcast_ring_buffer overwrite", "[broadcast_ring_buffer]") {
+	broadcast_ring_buffer<int, 4, 2, broadcast_policy::overwrite> ring;
+	for (int i = 0; i < 10; ++i) CHECK(ring.try_push(i));
+
+	// The slot after the writer may be overwritten next, so a lapped consumer resumes one past it
+	int value = 0;
+	std::vector<int> values;
+	while (ring.try_pop(0, value)) values.push_back(value);
+	CHECK_THAT(values, Equals(std::vector<int>{ 7, 8, 9 }));
+	CHECK(ring.dropped(0) == 7);
+	CHECK(ring.dropped(1) == 0);
+
+	ring.try_push(10);
+	CHECK(ring.try_pop(0, value));
+	CHECK(value == 10);
+	CHECK(ring.dropped(0) == 7);
+}
+
+// Writes [0, num_values) and checks each consumer reads them all in order
+template<int Capacity, int Consumers>
+static bool run_broadcast(broadcast_ring_buffer<long long, Capacity, Consumers>& ring, long long num_values) {
+	std::vector<long long> sums(Consumers, 0);
+	std::vector<int> in_order(Consumers, 1);
+	std::vector<std::thread> threads;
+	for (int c = 0; c < Consumers; ++c) {
+		threads.emplace_back([&, c]() {
+			pin_this_thread(1 + c);
+			long long expected = 0;
+			while (expected < num_values) {
+				const int n = ring.consume(c, [&](const long long& v) {
+					in_order[c] = in_order[c] && v == expected;
+					sums[c] += v;
+					expected++;
+				});
+				if (n == 0) std::this_thread::yield();
+			}
+		});
+	}
+	scoped_pin pin(0);
+	for (long long i = 0; i < num_values; ++i) {
+		while (!ring.try_push(i)) std::this_thread::yield();
+	}
+	for (auto& t : threads) t.join();
+
+	bool ok = true;
+	for (int c = 0; c < Consumers; ++c) ok = ok && in_order[c] && sums[c] == num_values * (num_values - 1) / 2;
+	return ok;
+}
+
+TEST_CASE("broadcast_ring_buffer threads", "[broadcast_ring_buffer]") {
+	broadcast_ring_buffer<long long, 64, 3> ring;
+	CHECK(run_broadcast(ring, 50000));
+	for (int c = 0; c < 3; ++c) CHECK(ring.empty(c));
+}
+
+TEST_CASE("broadcast_ring_buffer overwrite threads", "[broadcast_ring_buffer]") {
+	// A lapped consumer skips ahead but never returns a torn or out of order event
+	struct event {
+		long long a, b;
+	};
+	broadcast_ring_buffer<event, 16, 1, broadcast_policy::overwrite> ring;
+	const long long num_values = 100000;
+	bool consistent = true;
+	long long received = 0;
+	std::thread consumer([&]() {
+		event e {0, 0};
+		long long last = -1;
+		while (last < num_values - 1) {
+			if (ring.try_pop(0, e)) {
+				consistent = consistent && e.a == e.b && e.a > last;
+				last = e.a;
+				received++;
+			}
+			else std::this_thread::yield();
+		}
+	});
+	for (long long i = 0; i < num_values; ++i) {
+		ring.try_push(event { i, i });
+		if (i % 64 == 0) std::this_thread::yield();
+	}
+	consumer.join();
+	CHECK(consistent);
+	CHECK(received + (long long) ring.dropped(0) == num_values);
+}
+
+// The alternative to broadcasting: the writer copies each event into one ring per consumer
+// The rings are automatic objects: plain new doesn't honour their cache line alignment before C++17
+template<int Consumers> static void run_copy_per_consumer(long long num_values) {
+	std::array<spsc_ring_buffer<long long, 1024>, Consumers> rings;
+	std::vector<std::thread> threads;
+	for (int c = 0; c < Consumers; ++c) {
+		threads.emplace_back([&, c]() {
+			pin_this_thread(1 + c);
+			long long value = 0;
+			for (long long i = 0; i < num_values; ++i) {
+				while (!rings[c].try_pop(value)) std::this_thread::yield();
+			}
+		});
+	}
+	scoped_pin pin(0);
+	for (long long i = 0; i < num_values; ++i) {
+		for (auto& ring : rings) {
+			while (!ring.try_push(i)) std::this_thread::yield();
+		}
+	}
+	for (auto& t : threads) t.join();
+}
+
+TEST_CASE("broadcast_ring_buffer (benchmarks)", "[!benchmark][broadcast_ring_buffer]") {
+	static const long long num_values = 1 << 18;
+
+	BENCHMARK("broadcast: 1 consumer") {
+		broadcast_ring_buffer<long long, 1024, 1> ring;
+		run_broadcast(ring, num_values);
+	}
+
+	BENCHMARK("broadcast: 2 consumers") {
+		broadcast_ring_buffer<long long, 1024, 2> ring;
+		run_broadcast(ring, num_values);
+	}
+
+	BENCHMARK("broadcast: 4 consumers") {
+		broadcast_ring_buffer<long long, 1024, 4> ring;
+		run_broadcast(ring, num_values);
+	}
+
+	BENCHMARK("broadcast: 8 consumers") {
+		broadcast_ring_buffer<long long, 1024, 8> ring;
+		run_broadcast(ring, num_values);
+	}
+
+	BENCHMARK("copy per consumer: 1 consumer") { run_copy_per_consumer<1>(num_values); }
+
+	BENCHMARK("copy per consumer: 2 consumers") { run_copy_per_consumer<2>(num_values); }
+
+	BENCHMARK("copy per consumer: 4 consumers") { run_copy_per_consumer<4>(num_values); }
+
+	BENCHMARK("copy per consumer: 8 consumers") { run_copy_per_consumer<8>(num_values); }
+}
+
+// Pushes [0, num_values) from one thread and pops them on another
+template<typename Ring> static bool run_blocking(Ring& ring, int num_values) {
+	bool in_order = true;
+	std::thread consumer([&]() {
+		int value = 0;
+		for (int i = 0; i < num_values; ++i) {
+			ring.pop(value);
+			in_order = in_order && value == i;
+		}
+	});
+	for (int i = 0; i < num_values; ++i) ring.push(i);
+	consumer.join();
+	return in_order && ring.empty();
+}
+
+TEST_CASE("blocking_ring_buffer", "[blocking_ring_buffer]") {
+	SECTION("non-blocking operations") {
+		blocking_ring_buffer<int, 2> ring;
+		int value = 0;
+		CHECK(!ring.try_pop(value));
+		CHECK(ring.try_push(1));
+		CHECK(ring.try_push(2));
+		CHECK(!ring.try_push(3));
+		ring.pop(value);
+		CHECK(value == 1);
+		ring.push(3);
+		CHECK(ring.count() == 2);
+	}
+
+	SECTION("smallest capacity, producer always waiting for a free slot") {
+		blocking_ring_buffer<int, 2> ring;
+		CHECK(run_blocking(ring, 20000));
+	}
+
+	SECTION("busy spin") {
+		blocking_ring_buffer<int, 16, bsp::busy_spin_wait> ring;
+		CHECK(run_blocking(ring, 200));
+	}
+
+	SECTION("spin then yield") {
+		blocking_ring_buffer<int, 16, bsp::spin_yield_wait<>> ring;
+		CHECK(run_blocking(ring, 20000));
+	}
+
+	SECTION("sleeping") {
+		blocking_ring_buffer<int, 16, bsp::sleeping_wait<>> ring;
+		CHECK(run_blocking(ring, 20000));
+	}
+
+	SECTION("sleeping with batched wakeups") {
+		// Batches that never fill up are delivered after the maximum delay
+		blocking_ring_buffer<int, 16, bsp::sleeping_wait<8, 200>> ring;
+		CHECK(run_blocking(ring, 20000));
+	}
+
+	SECTION("sleeper is woken by a push") {
+		blocking_ring_buffer<std::unique_ptr<int>, 4, bsp::sleeping_wait<1, 10000000>> ring;
+		std::unique_ptr<int> value;
+		std::thread consumer([&]() { ring.pop(value); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		const auto start = std::chrono::steady_clock::now();
+		ring.push(std::unique_ptr<int>(new int(42)));
+		consumer.join();
+		REQUIRE(value);
+		CHECK(*value == 42);
+		CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5)); // Well below the 10s timeout
+	}
+}
+
+// Counts latencies in power of two nanosecond buckets
+class latency_histogram {
+public:
+	void add(std::int64_t ns) {
+		int bucket = 0;
+		while (bucket < num_buckets - 1 && (std::int64_t(1) << (bucket + 1)) <= ns) bucket++;
+		counts_[bucket]++;
+		total_++;
+	}
+
+	// Upper bound of the bucket holding the given percentile
+	std::int64_t percentile(double p) const {
+		const std::int64_t rank = static_cast<std::int64_t>(p / 100.0 * (total_ - 1));
+		std::int64_t seen = 0;
+		for (int bucket = 0; bucket < num_buckets; ++bucket) {
+			seen += counts_[bucket];
+			if (seen > rank) return std::int64_t(1) << (bucket + 1);
+		}
+		return std::int64_t(1) << num_buckets;
+	}
+
+protected:
+	static const int num_buckets = 40;
+	std::array<std::int64_t, num_buckets> counts_ {};
+	std::int64_t total_ = 0;
+};
+
+// Sends timestamps at a fixed rate (0 = as fast as possible) and records how long each takes to arrive
+template<typename Wait> static latency_histogram measure_latency(int messages_per_second, int num_messages) {
+	using clock = std::chrono::steady_clock;
+	blocking_ring_buffer<std::int64_t, 256, Wait> ring;
+	latency_histogram histogram;
+	std::thread consumer([&]() {
+		pin_this_thread(1);
+		std::int64_t sent = 0;
+		for (int i = 0; i < num_messages; ++i) {
+			ring.pop(sent);
+			histogram.add(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count() - sent);
+		}
+	});
+	scoped_pin pin(0);
+	const auto interval = messages_per_second > 0 ? std::chrono::nanoseconds(1000000000 / messages_per_second) : std::chrono::nanoseconds(0);
+	auto next = clock::now();
+	for (int i = 0; i < num_messages; ++i) {
+		while (clock::now() < next) {}
+		next += interval;
+		ring.push(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count());
+	}
+	consumer.join();
+	return histogram;
+}
+
+template<typename Wait> static void print_latency(const char* name) {
+	for (int rate : { 10000, 100000, 0 }) {
+		const latency_histogram h = measure_latency<Wait>(rate, rate == 10000 ? 5000 : 50000);
+		std::printf("%-22s %9s msg/s: p50 < %8lld ns, p99 < %9lld ns, p99.9 < %9lld ns\n", name,
+					rate ? std::to_string(rate).c_str() : "max", (long long) h.percentile(50), (long long) h.percentile(99),
+					(long long) h.percentile(99.9));
+	}
+}
+
+TEST_CASE("blocking_ring_buffer (benchmarks)", "[!benchmark][blocking_ring_buffer]") {
+	static const int num_values = 1 << 18;
+
+	print_latency<bsp::busy_spin_wait>("busy_spin_wait");
+	print_latency<bsp::spin_yield_wait<>>("spin_yield_wait");
+	print_latency<bsp::sleeping_wait<>>("sleeping_wait");
+	print_latency<bsp::sleeping_wait<16, 100>>("sleeping_wait batch 16");
+
+	BENCHMARK("throughput: busy_spin_wait") {
+		blocking_ring_buffer<int, 1024, bsp::busy_spin_wait> ring;
+		run_blocking(ring, num_values);
+	}
+
+	BENCHMARK("throughput: spin_yield_wait") {
+		blocking_ring_buffer<int, 1024, bsp::spin_yield_wait<>> ring;
+		run_blocking(ring, num_values);
+	}
+
+	BENCHMARK("throughput: sleeping_wait") {
+		blocking_ring_buffer<int, 1024, bsp::sleeping_wait<>> ring;
+		run_blocking(ring, num_values);
+	}
+
+	BENCHMARK("throughput: sleeping_wait batch 16") {
+		blocking_ring_buffer<int, 1024, bsp::sleeping_wait<16, 100>> ring;
+		run_blocking(ring, num_values);
+	}
+}
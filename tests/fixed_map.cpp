@@ -1,9 +1,11 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
@@ -13,11 +15,13 @@
 // #define BSP_FIXED_MAP_THROWS
 #define BSP_FIXED_MAP_LOG_ERROR(message) std::cerr << message << "\n"
 #include "../include/fixed_map.h"
+#include "../include/fixed_string.h"
 
 #include "catch.hpp"
 #include "container_matcher.h"
 
 using bsp::fixed_map;
+using bsp::fixed_string;
 using Catch::Equals;
 
 TEST_CASE("fixed_map basics", "[fixed_map]") {
@@ -103,3 +107,360 @@ TEST_CASE("fixed_map exception in insertion", "[fixed_map]") {
     map.insert(1, 1);
     CHECK_THROWS_AS(map.insert(2, 1), std::length_error);
 }
+
+TEST_CASE("fixed_map erase", "[fixed_map]") {
+    // Keys 1, 9 and 17 share home slot 1, 2 lands after them
+    fixed_map<int, int, 8> map { {1, 10}, {9, 90}, {17, 170}, {2, 20} };
+    CHECK(map.erase(5) == 0);
+
+    SECTION("shifts the probe run back") {
+        CHECK(map.erase(1) == 1);
+        CHECK(map.size() == 3);
+        CHECK(!map.has(1));
+        CHECK(map[9] == 90);
+        CHECK(map[17] == 170);
+        CHECK(map[2] == 20);
+        // No tombstone: 9 moved into its home slot
+        CHECK(std::next(map.begin(), 1)->key == 9);
+        CHECK(!std::next(map.begin(), 4)->valid);
+    }
+
+    SECTION("erase and reinsert") {
+        CHECK(map.erase(17) == 1);
+        CHECK(map.erase(17) == 0);
+        map.insert(25, 250);
+        CHECK(map[25] == 250);
+        CHECK(map[2] == 20);
+        CHECK(map.size() == 4);
+    }
+
+    SECTION("probe runs that wrap around the end") {
+        fixed_map<int, int, 4> wrapped { {3, 30}, {7, 70}, {11, 110} };
+        CHECK(wrapped.erase(3) == 1);
+        CHECK(wrapped[7] == 70);
+        CHECK(wrapped[11] == 110);
+        CHECK(wrapped.begin()->key == 11);
+        CHECK(std::next(wrapped.begin(), 3)->key == 7);
+    }
+
+    SECTION("full map") {
+        fixed_map<int, int, 4> full { {1, 10}, {5, 50}, {2, 20}, {0, 0} };
+        CHECK(full.erase(1) == 1);
+        CHECK(full.size() == 3);
+        CHECK(full[5] == 50);
+        CHECK(full[2] == 20);
+        CHECK(full[0] == 0);
+    }
+}
+
+// Checks the linear probing invariant: every element is reachable from its home slot without
+// crossing an empty slot
+template<typename Map> static bool probe_runs_unbroken(const Map& map) {
+    const int n = map.max_size();
+    for (int i = 0; i < n; ++i) {
+        const auto& slot = *std::next(map.begin(), i);
+        if (!slot.valid) continue;
+        for (int j = static_cast<int>(std::hash<int>{}(slot.key) % n); j != i; j = (j + 1) % n) {
+            if (!std::next(map.begin(), j)->valid) return false;
+        }
+    }
+    return true;
+}
+
+// Checks the robin hood invariants: every element stores its distance from home, and no
+// element is further from its home than the one after it could have been
+template<typename Map> static bool probe_distances_ordered(const Map& map) {
+    const int n = map.max_size();
+    for (int i = 0; i < n; ++i) {
+        const auto& slot = *std::next(map.begin(), i);
+        if (!slot.valid) continue;
+        const int home = static_cast<int>(std::hash<int>{}(slot.key) % n);
+        if (slot.probe_distance != (i - home + n) % n) return false;
+        const auto& next = *std::next(map.begin(), (i + 1) % n);
+        if (next.valid && next.probe_distance > slot.probe_distance + 1) return false;
+    }
+    return true;
+}
+
+template<typename Map, typename Invariant> static void randomised_insert_and_erase(Invariant invariant) {
+    std::default_random_engine engine { 0 };
+    std::uniform_int_distribution<int> keys { 0, 200 };
+    Map map { -1 };
+    std::map<int, int> reference;
+
+    for (int i = 0; i < 20000; ++i) {
+        const int key = keys(engine);
+        if (reference.count(key)) {
+            CHECK(map.erase(key) == 1);
+            reference.erase(key);
+        }
+        else if (map.size() < map.max_size()) {
+            map.insert(key, i);
+            reference[key] = i;
+        }
+        if (i % 100 == 0) {
+            REQUIRE(map.size() == (int) reference.size());
+            REQUIRE(probe_runs_unbroken(map));
+            REQUIRE(invariant(map));
+            for (const auto& kv : reference) REQUIRE(map[kv.first] == kv.second);
+            for (int k = 201; k < 210; ++k) REQUIRE_FALSE(map.has(k));
+        }
+    }
+}
+
+TEST_CASE("fixed_map randomised insert and erase", "[fixed_map]") {
+    using map_type = fixed_map<int, int, 61>;
+    randomised_insert_and_erase<map_type>([](const map_type&) { return true; });
+}
+
+TEST_CASE("fixed_map robin hood probing", "[fixed_map]") {
+    using map_type = fixed_map<int, int, 8, std::hash<int>, bsp::probing::robin_hood>;
+    CHECK(map_type::probing_mode == bsp::probing::robin_hood);
+    map_type map { -1 };
+
+    SECTION("takes the slot of an element closer to its home") {
+        map.insert(1, 1);
+        map.insert(2, 2);
+        map.insert(9, 9); // Home 1, moves 2 on
+        CHECK(std::next(map.begin(), 1)->key == 1);
+        CHECK(std::next(map.begin(), 2)->key == 9);
+        CHECK(std::next(map.begin(), 3)->key == 2);
+        CHECK(std::next(map.begin(), 3)->probe_distance == 1);
+        CHECK(map.find(2) == 2);
+        CHECK(map.find(9) == 9);
+        CHECK_FALSE(map.has(17));
+        CHECK(probe_distances_ordered(map));
+    }
+
+    SECTION("insert returns the new element") {
+        map.insert(1, 1);
+        map.insert(2, 2);
+        CHECK(map.insert(9, 9)->key == 9);
+    }
+
+    SECTION("erase shifts the run back") {
+        map.insert(1, 1);
+        map.insert(9, 9);
+        map.insert(2, 2);
+        map.insert(3, 3);
+        CHECK(map.erase(1) == 1);
+        CHECK(std::next(map.begin(), 1)->key == 9);
+        CHECK(std::next(map.begin(), 2)->key == 2);
+        CHECK(std::next(map.begin(), 3)->key == 3);
+        CHECK_FALSE(std::next(map.begin(), 4)->valid);
+        CHECK(probe_distances_ordered(map));
+    }
+
+    SECTION("full map") {
+        for (int i = 0; i < 8; ++i) map.insert(i * 8, i); // All home 0
+        CHECK(map.size() == 8);
+        CHECK(probe_distances_ordered(map));
+        CHECK_FALSE(map.has(100));
+        for (int i = 0; i < 8; ++i) CHECK(map.erase(i * 8) == 1);
+        CHECK(map.empty());
+    }
+
+    SECTION("randomised insert and erase") {
+        randomised_insert_and_erase<fixed_map<int, int, 61, std::hash<int>, bsp::probing::robin_hood>>(
+            [](const fixed_map<int, int, 61, std::hash<int>, bsp::probing::robin_hood>& m) { return probe_distances_ordered(m); });
+    }
+}
+
+// A key that counts how often it is compared, to see how many slots a lookup looks at
+struct counted_key {
+    static int comparisons;
+    int value = 0;
+
+    counted_key() = default;
+    counted_key(int value_) : value(value_) {}
+
+    bool operator==(const counted_key& other) const {
+        comparisons++;
+        return value == other.value;
+    }
+};
+int counted_key::comparisons = 0;
+
+struct counted_key_hash {
+    std::size_t operator()(const counted_key& key) const { return static_cast<std::size_t>(key.value); }
+};
+
+TEST_CASE("fixed_map lookup", "[fixed_map]") {
+    fixed_map<counted_key, int, 16, counted_key_hash> map;
+
+    SECTION("a miss stops at the first empty slot") {
+        map.insert(1, 1);
+        map.insert(2, 2);
+        counted_key::comparisons = 0;
+        CHECK_FALSE(map.has(5));
+        CHECK_FALSE(map.has(3));
+        CHECK(counted_key::comparisons == 0);
+    }
+
+    SECTION("fingerprints skip keys sharing a home slot") {
+        // All of them hash to slot 3 under the identity hash, the mixed fingerprints still differ
+        for (int i = 0; i < 8; ++i) map.insert(3 + 16 * i, i);
+        counted_key::comparisons = 0;
+        CHECK(map.find(3 + 16 * 7) == 7);
+        CHECK(counted_key::comparisons == 1);
+        counted_key::comparisons = 0;
+        CHECK_FALSE(map.has(3 + 16 * 8));
+        CHECK(counted_key::comparisons == 0);
+    }
+
+    SECTION("full map") {
+        for (int i = 0; i < 16; ++i) map.insert(i * 7, i);
+        for (int i = 0; i < 16; ++i) CHECK(map.find(i * 7) == i);
+        CHECK_FALSE(map.has(1));
+        CHECK(map.erase(0) == 1);
+        CHECK_FALSE(map.has(0));
+        for (int i = 1; i < 16; ++i) CHECK(map.find(i * 7) == i);
+    }
+}
+
+// FNV-1a
+struct fixed_string_hash {
+    template<int N> std::size_t operator()(const fixed_string<N>& key) const {
+        std::size_t h = 2166136261u;
+        for (char c : key) h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+        return h;
+    }
+};
+
+// Fills a map to load_percent and times finding the keys in it, then keys that aren't
+template<typename Key, int Capacity, typename Hash, typename MakeKey>
+static void benchmark_lookups(const std::string& label, int load_percent, MakeKey make_key) {
+    const int size = Capacity * load_percent / 100;
+    std::vector<Key> present, absent;
+    for (int i = 0; i < size; ++i) {
+        present.push_back(make_key(2 * i));
+        absent.push_back(make_key(2 * i + 1));
+    }
+    fixed_map<Key, int, Capacity, Hash> map;
+    for (int i = 0; i < size; ++i) map.insert(present[i], i);
+
+    const std::string hits = label + " hits at " + std::to_string(load_percent) + "% load";
+    const std::string misses = label + " misses at " + std::to_string(load_percent) + "% load";
+    BENCHMARK(hits) {
+        int found = 0;
+        for (int round = 0; round < 64; ++round) {
+            for (const auto& key : present) found += map.has(key);
+        }
+        CHECK(found == 64 * size);
+    }
+    BENCHMARK(misses) {
+        int found = 0;
+        for (int round = 0; round < 64; ++round) {
+            for (const auto& key : absent) found += map.has(key);
+        }
+        CHECK(found == 0);
+    }
+}
+
+TEST_CASE("fixed_map lookup (benchmarks)", "[!benchmark][fixed_map]") {
+    // Scrambles the keys, std::hash<int> is the identity
+    struct int_hash {
+        std::size_t operator()(int key) const { return static_cast<std::size_t>(key) * 0x9e3779b97f4a7c15ull >> 16; }
+    };
+    auto make_int = [](int i) { return i; };
+    auto make_string = [](int i) { return fixed_string<16>("key-" + std::to_string(i)); };
+
+    for (int load : { 25, 50, 75, 90 }) {
+        SECTION("int keys, " + std::to_string(load) + "% load") {
+            benchmark_lookups<int, 1024, int_hash>("int", load, make_int);
+        }
+        // The even keys fill one run of home slots, so misses probe long clusters at high load
+        SECTION("int keys with std::hash, " + std::to_string(load) + "% load") {
+            benchmark_lookups<int, 1024, std::hash<int>>("int (std::hash)", load, make_int);
+        }
+        SECTION("fixed_string<16> keys, " + std::to_string(load) + "% load") {
+            benchmark_lookups<fixed_string<16>, 1024, fixed_string_hash>("fixed_string", load, make_string);
+        }
+    }
+}
+
+TEST_CASE("fixed_map erase (benchmarks)", "[!benchmark][fixed_map]") {
+    static const int num_operations = 1 << 18;
+    std::default_random_engine engine { 0 };
+    std::vector<int> keys(num_operations);
+    std::uniform_int_distribution<int> distribution { 0, 1 << 20 };
+    for (auto& key : keys) key = distribution(engine);
+
+    // Keeps 768 of 1024 slots in use, erasing the oldest key for every insert
+    BENCHMARK("churn at 75% load: insert + erase") {
+        fixed_map<int, int, 1024> map;
+        const int live = 768;
+        int sum = 0;
+        for (int i = 0; i < num_operations; ++i) {
+            if (i >= live) map.erase(keys[i - live]);
+            if (!map.has(keys[i])) map.insert(keys[i], i);
+            sum += map.find(keys[i]);
+        }
+        CHECK(sum != 0);
+    }
+
+    BENCHMARK("churn at 75% load: rebuild (1/64 of the ops)") {
+        fixed_map<int, int, 1024> map;
+        const int live = 768;
+        for (int i = live; i < num_operations / 64; ++i) {
+            fixed_map<int, int, 1024> rebuilt;
+            for (int k = i - live + 1; k <= i; ++k) {
+                if (!rebuilt.has(keys[k])) rebuilt.insert(keys[k], k);
+            }
+            map = rebuilt;
+        }
+        CHECK(map.size() > 0);
+    }
+}
+
+// Times the lookup of every key on its own (averaged over a few repeats so the clock's overhead
+// doesn't dominate), returns the sorted latencies in ns
+template<typename Map> static std::vector<double> lookup_latencies(const Map& map, const std::vector<int>& keys) {
+    using clock = std::chrono::steady_clock;
+    static const int repeats = 16;
+    std::vector<double> latencies;
+    int found = 0;
+    for (int key : keys) {
+        volatile int k = key; // Keeps the lookups in the loop
+        const auto start = clock::now();
+        for (int r = 0; r < repeats; ++r) found += map.has(static_cast<int>(k));
+        latencies.push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count() / repeats);
+    }
+    CHECK(found >= 0);
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+template<bsp::probing Probing> static void print_lookup_latencies(const char* name, int load_percent) {
+    static const int capacity = 1024;
+    using map_type = fixed_map<int, int, capacity, std::hash<int>, Probing>;
+    std::default_random_engine engine { 0 };
+    std::uniform_int_distribution<int> distribution { 0, 1 << 20 };
+    std::unique_ptr<map_type> map { new map_type() };
+    std::vector<int> present, absent;
+    while (map->size() < capacity * load_percent / 100) {
+        const int key = distribution(engine);
+        if (map->has(key)) continue;
+        map->insert(key, key);
+        present.push_back(key);
+    }
+    while (absent.size() < present.size()) {
+        const int key = distribution(engine);
+        if (!map->has(key)) absent.push_back(key);
+    }
+    for (int hit = 1; hit >= 0; --hit) {
+        const std::vector<double> l = lookup_latencies(*map, hit ? present : absent);
+        auto at = [&l](double p) { return l[static_cast<std::size_t>(p / 100.0 * (l.size() - 1))]; };
+        std::printf("%-10s %2d%% load %-6s: p50 %6.1f ns, p90 %6.1f ns, p99 %6.1f ns, max %6.1f ns\n", name,
+                    load_percent, hit ? "hits" : "misses", at(50), at(90), at(99), l.back());
+    }
+}
+
+// std::hash<int> is the identity, so random keys leave their home slots where they fall and
+// clusters grow as the map fills
+TEST_CASE("fixed_map robin hood probing (benchmarks)", "[!benchmark][fixed_map]") {
+    for (int load : { 50, 75, 90 }) {
+        print_lookup_latencies<bsp::probing::linear>("linear", load);
+        print_lookup_latencies<bsp::probing::robin_hood>("robin_hood", load);
+    }
+}
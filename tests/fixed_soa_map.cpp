@@ -0,0 +1,206 @@
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/fixed_map.h"
+#include "../include/fixed_soa_map.h"
+#include "catch.hpp"
+
+using bsp::fixed_map;
+using bsp::fixed_soa_map;
+
+TEST_CASE("fixed_soa_map basics", "[fixed_soa_map]") {
+	fixed_soa_map<int, int, 8> map { -1 };
+	CHECK(map.empty());
+	CHECK(map.max_size() == 8);
+
+	map.insert(0, 0);
+	map.insert(1, 42);
+	map.insert(9, 9); // Home 1
+	CHECK(map.size() == 3);
+	CHECK(map[0] == 0);
+	CHECK(map[1] == 42);
+	CHECK(map[9] == 9);
+	CHECK_FALSE(map.has(2));
+	CHECK(map.find(17) == -1);
+
+	map.find(1) = 43;
+	CHECK(map[1] == 43);
+
+	CHECK(map.erase(1) == 1);
+	CHECK(map.erase(1) == 0);
+	CHECK(map[9] == 9);
+	CHECK(map.size() == 2);
+
+	map.clear();
+	CHECK(map.empty());
+	CHECK_FALSE(map.has(0));
+}
+
+TEST_CASE("fixed_soa_map construction", "[fixed_soa_map]") {
+	SECTION("initialiser list construction") {
+		fixed_soa_map<std::string, int, 8> map { { "hp", 16 }, { "mp", 7 }, { "int", 3 } };
+		CHECK(map["hp"] == 16);
+		CHECK(map["int"] == 3);
+	}
+
+	SECTION("container construction") {
+		std::vector<std::pair<int, int>> els { { 0, 0 }, { 1, 42 } };
+		fixed_soa_map<int, int, 8> map { els };
+		CHECK(map[1] == 42);
+	}
+
+	SECTION("copy construction") {
+		fixed_soa_map<int, int, 8> map1 { { 0, 0 }, { 1, 42 } };
+		fixed_soa_map<int, int, 8> map2 { map1 };
+		CHECK(map2[1] == 42);
+	}
+}
+
+TEST_CASE("fixed_soa_map exceptions", "[fixed_soa_map]") {
+	CHECK_THROWS_AS((fixed_soa_map<int, int, 2>({ { 0, 0 }, { 1, 42 }, { 6, 70 } })), std::length_error);
+
+	fixed_soa_map<int, int, 2> map;
+	map.insert(0, 0);
+	map.insert(1, 1);
+	CHECK_THROWS_AS(map.insert(2, 1), std::length_error);
+}
+
+TEST_CASE("fixed_soa_map has no padding", "[fixed_soa_map]") {
+	using soa_map = fixed_soa_map<std::uint32_t, std::uint32_t, 1024>;
+	using interleaved_map = fixed_map<std::uint32_t, std::uint32_t, 1024>;
+	CHECK(sizeof(soa_map) <= 1024 * 8 + 1024 / 8 + 16);
+	CHECK(sizeof(soa_map) < sizeof(interleaved_map));
+}
+
+TEST_CASE("fixed_soa_map iteration and operator<<", "[fixed_soa_map]") {
+	// Spans several bitmap words, with empty words in between
+	fixed_soa_map<int, int, 300> map;
+	const std::vector<int> keys { 0, 1, 63, 64, 65, 200, 299 };
+	for (int key : keys) map.insert(key, key * 10);
+
+	std::vector<int> seen;
+	for (auto it = map.begin(); it != map.end(); ++it) {
+		CHECK(it->value == it->key * 10);
+		seen.push_back(it->key);
+	}
+	CHECK(seen == keys);
+
+	for (auto el : map) el.value++;
+	const auto& cmap = map;
+	fixed_soa_map<int, int, 300>::const_iterator it = cmap.begin();
+	CHECK(it->value == 1);
+
+	fixed_soa_map<int, int, 300> empty;
+	CHECK(empty.begin() == empty.end());
+
+	fixed_soa_map<std::string, int, 8> m2 { { "hp", 16 }, { "mp", 7 } };
+	std::cout << m2 << "\n";
+}
+
+TEST_CASE("fixed_soa_map randomised insert and erase", "[fixed_soa_map]") {
+	std::default_random_engine engine { 0 };
+	std::uniform_int_distribution<int> keys { 0, 200 };
+	fixed_soa_map<int, int, 61> map { -1 };
+	std::map<int, int> reference;
+
+	for (int i = 0; i < 20000; ++i) {
+		const int key = keys(engine);
+		if (reference.count(key)) {
+			CHECK(map.erase(key) == 1);
+			reference.erase(key);
+		}
+		else if (map.size() < map.max_size()) {
+			map.insert(key, i);
+			reference[key] = i;
+		}
+		if (i % 100 == 0) {
+			REQUIRE(map.size() == (int) reference.size());
+			for (const auto& kv : reference) REQUIRE(map[kv.first] == kv.second);
+			for (int k = 201; k < 210; ++k) REQUIRE_FALSE(map.has(k));
+			std::map<int, int> iterated;
+			for (auto el : map) iterated[el.key] = el.value;
+			REQUIRE(iterated == reference);
+		}
+	}
+}
+
+// std::hash of an integer is the identity, which clusters the benchmark's keys
+struct scrambled_hash {
+	std::size_t operator()(std::uint32_t key) const { return static_cast<std::size_t>(key * 0x9e3779b1u); }
+};
+
+TEST_CASE("fixed_soa_map (benchmarks)", "[!benchmark][fixed_soa_map]") {
+	static const int capacity = 4096;
+	using soa_map = fixed_soa_map<std::uint32_t, std::uint32_t, capacity, scrambled_hash>;
+	using interleaved_map = fixed_map<std::uint32_t, std::uint32_t, capacity, scrambled_hash>;
+
+	for (int load : { 10, 50, 75, 90 }) {
+		SECTION(std::to_string(load) + "% load") {
+			std::unique_ptr<soa_map> soa { new soa_map() };
+			std::unique_ptr<interleaved_map> interleaved { new interleaved_map() };
+			std::vector<std::uint32_t> present, absent;
+			for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(capacity * load / 100); ++i) {
+				present.push_back(2 * i);
+				absent.push_back(2 * i + 1);
+				soa->insert(2 * i, i);
+				interleaved->insert(2 * i, i);
+			}
+
+			const std::string prefix = std::to_string(load) + "% ";
+			const std::string names[] = { prefix + "hits: fixed_map", prefix + "hits: soa", prefix + "misses: fixed_map",
+										  prefix + "misses: soa", prefix + "iterate: fixed_map", prefix + "iterate: soa" };
+			BENCHMARK(names[0]) {
+				std::uint32_t sum = 0;
+				for (int round = 0; round < 16; ++round) {
+					for (std::uint32_t key : present) sum += interleaved->find(key);
+				}
+				CHECK(sum != 1);
+			}
+			BENCHMARK(names[1]) {
+				std::uint32_t sum = 0;
+				for (int round = 0; round < 16; ++round) {
+					for (std::uint32_t key : present) sum += soa->find(key);
+				}
+				CHECK(sum != 1);
+			}
+			BENCHMARK(names[2]) {
+				int found = 0;
+				for (int round = 0; round < 16; ++round) {
+					for (std::uint32_t key : absent) found += interleaved->has(key);
+				}
+				CHECK(found == 0);
+			}
+			BENCHMARK(names[3]) {
+				int found = 0;
+				for (int round = 0; round < 16; ++round) {
+					for (std::uint32_t key : absent) found += soa->has(key);
+				}
+				CHECK(found == 0);
+			}
+			BENCHMARK(names[4]) {
+				std::uint32_t sum = 0;
+				for (int round = 0; round < 64; ++round) {
+					for (const auto& slot : *interleaved) {
+						if (slot.valid) sum += slot.value;
+					}
+				}
+				CHECK(sum != 1);
+			}
+			BENCHMARK(names[5]) {
+				std::uint32_t sum = 0;
+				for (int round = 0; round < 64; ++round) {
+					for (auto el : *soa) sum += el.value;
+				}
+				CHECK(sum != 1);
+			}
+		}
+	}
+}
@@ -0,0 +1,300 @@
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/fixed_map.h"
+#include "../include/fixed_string.h"
+#include "../include/fixed_swiss_map.h"
+#include "catch.hpp"
+
+using bsp::fixed_map;
+using bsp::fixed_string;
+using bsp::fixed_swiss_map;
+
+TEST_CASE("fixed_swiss_map basics", "[fixed_swiss_map]") {
+	fixed_swiss_map<int, int, 8> map { -1 };
+	CHECK(map.empty());
+	CHECK(map.max_size() == 8);
+
+	map.insert(0, 0);
+	map.insert(1, 42);
+	CHECK(map.size() == 2);
+	CHECK(map[0] == 0);
+	CHECK(map[1] == 42);
+	CHECK(map.has(1));
+	CHECK_FALSE(map.has(2));
+	CHECK(map.find(2) == -1);
+
+	map.find(1) = 43;
+	CHECK(map[1] == 43);
+
+	map.clear();
+	CHECK(map.empty());
+	CHECK_FALSE(map.has(1));
+}
+
+TEST_CASE("fixed_swiss_map construction", "[fixed_swiss_map]") {
+	SECTION("initialiser list construction") {
+		fixed_swiss_map<std::string, int, 8> map { { "hp", 16 }, { "mp", 7 }, { "int", 3 } };
+		CHECK(map["hp"] == 16);
+		CHECK(map["int"] == 3);
+	}
+
+	SECTION("container construction") {
+		std::vector<std::pair<int, int>> els { { 0, 0 }, { 1, 42 } };
+		fixed_swiss_map<int, int, 8> map { els };
+		CHECK(map[1] == 42);
+	}
+
+	SECTION("copy construction") {
+		fixed_swiss_map<int, int, 8> map1 { { 0, 0 }, { 1, 42 } };
+		fixed_swiss_map<int, int, 8> map2 { map1 };
+		CHECK(map2[1] == 42);
+	}
+}
+
+TEST_CASE("fixed_swiss_map exceptions", "[fixed_swiss_map]") {
+	CHECK_THROWS_AS((fixed_swiss_map<int, int, 2>({ { 0, 0 }, { 1, 42 }, { 6, 70 } })), std::length_error);
+
+	fixed_swiss_map<int, int, 2> map;
+	map.insert(0, 0);
+	map.insert(1, 1);
+	CHECK_THROWS_AS(map.insert(2, 1), std::length_error);
+}
+
+TEST_CASE("fixed_swiss_map iteration and operator<<", "[fixed_swiss_map]") {
+	fixed_swiss_map<int, int, 40> map;
+	for (int i = 0; i < 40; ++i) map.insert(i, i * 10);
+	map.erase(7);
+
+	std::map<int, int> seen;
+	for (auto it = map.begin(); it != map.end(); ++it) seen[it->key] = it->value;
+	CHECK(seen.size() == 39);
+	CHECK(seen.count(7) == 0);
+	CHECK(seen[39] == 390);
+
+	for (auto el : map) el.value++;
+	const auto& cmap = map;
+	fixed_swiss_map<int, int, 40>::const_iterator it = cmap.begin();
+	CHECK(it->value == it->key * 10 + 1);
+
+	fixed_swiss_map<std::string, int, 8> m2 { { "hp", 16 } };
+	std::cout << m2 << "\n";
+}
+
+// Sends every key to the same group with the same tag, so lookups rely on comparing keys
+struct constant_hash {
+	std::size_t operator()(int) const { return 0; }
+};
+
+TEST_CASE("fixed_swiss_map collisions", "[fixed_swiss_map]") {
+	fixed_swiss_map<int, int, 48, constant_hash> map { -1 };
+	for (int i = 0; i < 48; ++i) map.insert(i, i);
+	for (int i = 0; i < 48; ++i) CHECK(map[i] == i);
+	CHECK_FALSE(map.has(48));
+
+	SECTION("erase leaves tombstones in full groups") {
+		for (int i = 0; i < 48; i += 2) CHECK(map.erase(i) == 1);
+		CHECK(map.erase(0) == 0);
+		for (int i = 1; i < 48; i += 2) CHECK(map[i] == i);
+		for (int i = 0; i < 48; i += 2) CHECK_FALSE(map.has(i));
+	}
+
+	SECTION("inserts reuse tombstones") {
+		map.erase(3);
+		map.erase(40);
+		map.insert(100, 100);
+		map.insert(101, 101);
+		CHECK(map.size() == 48);
+		CHECK(map[100] == 100);
+		CHECK(map[101] == 101);
+		CHECK(map[47] == 47);
+	}
+}
+
+// Exposes the tombstone count
+template<typename Key, typename T, int Capacity, class Hash = std::hash<Key>>
+struct inspectable_swiss_map : fixed_swiss_map<Key, T, Capacity, Hash> {
+	int tombstones() const { return this->tombstones_; }
+	int empty_slots() const { return this->num_slots - this->size_ - this->tombstones_; }
+};
+
+TEST_CASE("fixed_swiss_map churn", "[fixed_swiss_map]") {
+	SECTION("tombstones never outnumber the empty slots") {
+		inspectable_swiss_map<int, int, 128> map;
+		std::map<int, int> reference;
+		for (int i = 0; i < 115; ++i) {
+			map.insert(i, i);
+			reference[i] = i;
+		}
+		// Replace the oldest key with a new one, many times over the capacity
+		for (int i = 115; i < 20000; ++i) {
+			map.insert(i, i);
+			reference[i] = i;
+			CHECK(map.erase(i - 115) == 1);
+			reference.erase(i - 115);
+			REQUIRE(map.tombstones() <= map.empty_slots());
+			if (i % 500 == 0) {
+				for (const auto& kv : reference) REQUIRE(map[kv.first] == kv.second);
+				for (int k = i - 200; k < i - 115; ++k) REQUIRE_FALSE(map.has(k));
+			}
+		}
+		CHECK(map.size() == 115);
+	}
+
+	SECTION("in-place cleanup keeps colliding keys reachable") {
+		inspectable_swiss_map<int, int, 48, constant_hash> map;
+		for (int i = 0; i < 48; ++i) map.insert(i, i);
+		for (int i = 0; i < 40; ++i) {
+			CHECK(map.erase(i) == 1);
+			REQUIRE(map.tombstones() <= map.empty_slots());
+		}
+		for (int i = 40; i < 48; ++i) CHECK(map[i] == i);
+		for (int i = 0; i < 40; ++i) CHECK_FALSE(map.has(i));
+		for (int i = 100; i < 140; ++i) map.insert(i, i);
+		CHECK(map.size() == 48);
+		for (int i = 100; i < 140; ++i) CHECK(map[i] == i);
+	}
+}
+
+TEST_CASE("fixed_swiss_map randomised insert and erase", "[fixed_swiss_map]") {
+	std::default_random_engine engine { 0 };
+	std::uniform_int_distribution<int> keys { 0, 200 };
+	fixed_swiss_map<int, int, 61> map { -1 };
+	std::map<int, int> reference;
+
+	for (int i = 0; i < 20000; ++i) {
+		const int key = keys(engine);
+		if (reference.count(key)) {
+			CHECK(map.erase(key) == 1);
+			reference.erase(key);
+		}
+		else if (map.size() < map.max_size()) {
+			map.insert(key, i);
+			reference[key] = i;
+		}
+		if (i % 100 == 0) {
+			REQUIRE(map.size() == (int) reference.size());
+			for (const auto& kv : reference) REQUIRE(map[kv.first] == kv.second);
+			for (int k = 201; k < 210; ++k) REQUIRE_FALSE(map.has(k));
+		}
+	}
+}
+
+// FNV-1a
+struct fixed_string_hash {
+	template<int N> std::size_t operator()(const fixed_string<N>& key) const {
+		std::size_t h = 2166136261u;
+		for (char c : key) h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+		return h;
+	}
+};
+
+// Swaps every present key for an absent one and back, so the map ends up holding the same keys
+// but its erases leave tombstones wherever a group was full
+template<typename Map, typename Key> static void churn(Map& map, const std::vector<Key>& present, const std::vector<Key>& absent) {
+	for (std::size_t i = 0; i < present.size(); ++i) {
+		map.erase(present[i]);
+		map.insert(absent[i], static_cast<int>(i));
+	}
+	for (std::size_t i = 0; i < present.size(); ++i) {
+		map.erase(absent[i]);
+		map.insert(present[i], static_cast<int>(i));
+	}
+}
+
+// Fills both maps to load_percent and times finding the keys in them, then keys that aren't,
+// then churning the keys and looking for missing keys again
+template<typename Key, typename Hash, typename MakeKey> static void benchmark_lookups(const std::string& label, int load_percent, MakeKey make_key) {
+	static const int capacity = 1024;
+	const int size = capacity * load_percent / 100;
+	std::vector<Key> present, absent;
+	for (int i = 0; i < size; ++i) {
+		present.push_back(make_key(2 * i));
+		absent.push_back(make_key(2 * i + 1));
+	}
+	fixed_map<Key, int, capacity, Hash> linear;
+	fixed_swiss_map<Key, int, capacity, Hash> swiss;
+	for (int i = 0; i < size; ++i) {
+		linear.insert(present[i], i);
+		swiss.insert(present[i], i);
+	}
+
+	const std::string prefix = label + " " + std::to_string(load_percent) + "% ";
+	const std::string names[] = { prefix + "hits: fixed_map", prefix + "hits: swiss", prefix + "misses: fixed_map", prefix + "misses: swiss",
+								  prefix + "churn: fixed_map", prefix + "churn: swiss", prefix + "misses after churn: fixed_map", prefix + "misses after churn: swiss" };
+	BENCHMARK(names[0]) {
+		int found = 0;
+		for (int round = 0; round < 64; ++round) {
+			for (const auto& key : present) found += linear.has(key);
+		}
+		CHECK(found == 64 * size);
+	}
+	BENCHMARK(names[1]) {
+		int found = 0;
+		for (int round = 0; round < 64; ++round) {
+			for (const auto& key : present) found += swiss.has(key);
+		}
+		CHECK(found == 64 * size);
+	}
+	BENCHMARK(names[2]) {
+		int found = 0;
+		for (int round = 0; round < 64; ++round) {
+			for (const auto& key : absent) found += linear.has(key);
+		}
+		CHECK(found == 0);
+	}
+	BENCHMARK(names[3]) {
+		int found = 0;
+		for (int round = 0; round < 64; ++round) {
+			for (const auto& key : absent) found += swiss.has(key);
+		}
+		CHECK(found == 0);
+	}
+
+	BENCHMARK(names[4]) {
+		churn(linear, present, absent);
+		CHECK(linear.size() == size);
+	}
+	BENCHMARK(names[5]) {
+		churn(swiss, present, absent);
+		CHECK(swiss.size() == size);
+	}
+	for (int round = 0; round < 16; ++round) {
+		churn(linear, present, absent);
+		churn(swiss, present, absent);
+	}
+	BENCHMARK(names[6]) {
+		int found = 0;
+		for (int round = 0; round < 64; ++round) {
+			for (const auto& key : absent) found += linear.has(key);
+		}
+		CHECK(found == 0);
+	}
+	BENCHMARK(names[7]) {
+		int found = 0;
+		for (int round = 0; round < 64; ++round) {
+			for (const auto& key : absent) found += swiss.has(key);
+		}
+		CHECK(found == 0);
+	}
+}
+
+TEST_CASE("fixed_swiss_map (benchmarks)", "[!benchmark][fixed_swiss_map]") {
+	auto make_int = [](int i) { return i; };
+	auto make_string = [](int i) { return fixed_string<16>("key-" + std::to_string(i)); };
+
+	for (int load : { 50, 75, 90 }) {
+		SECTION("int keys, " + std::to_string(load) + "% load") {
+			benchmark_lookups<int, std::hash<int>>("int", load, make_int);
+		}
+		SECTION("fixed_string<16> keys, " + std::to_string(load) + "% load") {
+			benchmark_lookups<fixed_string<16>, fixed_string_hash>("fixed_string", load, make_string);
+		}
+	}
+}
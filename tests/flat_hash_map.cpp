@@ -0,0 +1,310 @@
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../include/flat_hash_map.h"
+#include "catch.hpp"
+
+using bsp::flat_hash_map;
+
+// Every element can be found from its home slot, i.e. no probe run is broken by an empty slot
+template<typename Map> static bool probe_runs_unbroken(const Map& map) {
+	for (const auto& slot : map) {
+		if (slot.valid && map.find(slot.key) != slot.value) return false;
+	}
+	return true;
+}
+
+TEST_CASE("flat_hash_map basics", "[flat_hash_map]") {
+	flat_hash_map<int, int> map { -1 };
+	CHECK(map.empty());
+	CHECK(map.bucket_count() == 0);
+	CHECK_FALSE(map.has(0));
+	CHECK(map.find(0) == -1);
+	CHECK(map.erase(0) == 0);
+
+	map.insert(0, 0);
+	map.insert(1, 42);
+	CHECK(map.size() == 2);
+	CHECK(map[0] == 0);
+	CHECK(map[1] == 42);
+	CHECK_FALSE(map.has(2));
+	CHECK(map.find(2) == -1);
+
+	map.find(1) = 43;
+	CHECK(map[1] == 43);
+
+	SECTION("insert keeps an existing element") {
+		auto it = map.insert(1, 7);
+		CHECK(it->key == 1);
+		CHECK(it->value == 43);
+		CHECK(map.size() == 2);
+	}
+
+	SECTION("inserting a present key into a full map doesn't grow it") {
+		for (int i = 2; i < 6; ++i) map.insert(i, i);
+		// 6 of 8 slots, one more element would go over the max load factor
+		const std::size_t buckets = map.bucket_count();
+		REQUIRE(buckets == 8);
+		map.insert(5, 0);
+		CHECK(map.bucket_count() == buckets);
+		CHECK(map[5] == 5);
+		map.insert(6, 6);
+		CHECK(map.bucket_count() == buckets * 2);
+		for (int i = 2; i < 7; ++i) CHECK(map[i] == i);
+	}
+
+	SECTION("erase") {
+		CHECK(map.erase(1) == 1);
+		CHECK(map.erase(1) == 0);
+		CHECK_FALSE(map.has(1));
+		CHECK(map.size() == 1);
+	}
+
+	SECTION("clear keeps the slots") {
+		const std::size_t buckets = map.bucket_count();
+		map.clear();
+		CHECK(map.empty());
+		CHECK_FALSE(map.has(0));
+		CHECK(map.bucket_count() == buckets);
+	}
+}
+
+TEST_CASE("flat_hash_map construction", "[flat_hash_map]") {
+	SECTION("initialiser list construction") {
+		flat_hash_map<std::string, int> map { { "hp", 16 }, { "mp", 7 }, { "int", 3 } };
+		CHECK(map.size() == 3);
+		CHECK(map["hp"] == 16);
+		CHECK(map["int"] == 3);
+	}
+
+	SECTION("container construction") {
+		std::vector<std::pair<int, int>> els { { 0, 0 }, { 1, 42 } };
+		flat_hash_map<int, int> map { els };
+		CHECK(map[1] == 42);
+	}
+
+	SECTION("copy and move construction") {
+		flat_hash_map<int, int> map1 { { 0, 0 }, { 1, 42 } };
+		flat_hash_map<int, int> map2 { map1 };
+		CHECK(map2[1] == 42);
+		flat_hash_map<int, int> map3 { std::move(map1) };
+		CHECK(map3[1] == 42);
+
+		// The moved-from map is empty and usable
+		CHECK(map1.empty());
+		CHECK(map1.bucket_count() == 0);
+		CHECK_FALSE(map1.has(1));
+		CHECK(map1.erase(1) == 0);
+		map1.insert(7, 70);
+		CHECK(map1[7] == 70);
+
+		map2 = std::move(map1);
+		CHECK(map2.size() == 1);
+		CHECK(map2[7] == 70);
+		CHECK_FALSE(map1.has(7));
+		map1 = map3;
+		CHECK(map1[1] == 42);
+	}
+}
+
+TEST_CASE("flat_hash_map growth", "[flat_hash_map]") {
+	flat_hash_map<int, int> map { -1 };
+
+	SECTION("doubles when over the max load factor") {
+		for (int i = 0; i < 1000; ++i) {
+			map.insert(i, i * 2);
+			REQUIRE(map.load_factor() <= map.max_load_factor());
+		}
+		CHECK(map.bucket_count() == 2048);
+		for (int i = 0; i < 1000; ++i) REQUIRE(map[i] == i * 2);
+		CHECK_FALSE(map.has(1000));
+		CHECK(probe_runs_unbroken(map));
+	}
+
+	SECTION("reserve") {
+		map.reserve(1000);
+		const std::size_t buckets = map.bucket_count();
+		CHECK(buckets == 2048);
+		for (int i = 0; i < 1000; ++i) map.insert(i, i);
+		CHECK(map.bucket_count() == buckets);
+		map.reserve(10);
+		CHECK(map.bucket_count() == buckets);
+	}
+
+	SECTION("max load factor") {
+		map.max_load_factor(0.5f);
+		for (int i = 0; i < 64; ++i) map.insert(i, i);
+		CHECK(map.bucket_count() == 128);
+		map.max_load_factor(0.25f);
+		CHECK(map.bucket_count() == 256);
+		for (int i = 0; i < 64; ++i) REQUIRE(map[i] == i);
+
+		CHECK_THROWS_AS(map.max_load_factor(1.0f), std::invalid_argument);
+		CHECK_THROWS_AS(map.max_load_factor(0.0f), std::invalid_argument);
+	}
+
+	SECTION("a small max load factor holds from the first insert") {
+		map.max_load_factor(0.01f);
+		for (int i = 0; i < 100; ++i) {
+			map.insert(i, i);
+			REQUIRE(map.load_factor() <= map.max_load_factor());
+		}
+		for (int i = 0; i < 100; ++i) REQUIRE(map[i] == i);
+	}
+
+	SECTION("rehash can shrink") {
+		for (int i = 0; i < 1000; ++i) map.insert(i, i);
+		for (int i = 10; i < 1000; ++i) map.erase(i);
+		map.rehash(0);
+		CHECK(map.bucket_count() == 16);
+		for (int i = 0; i < 10; ++i) REQUIRE(map[i] == i);
+	}
+}
+
+TEST_CASE("flat_hash_map operator<<", "[flat_hash_map]") {
+	flat_hash_map<std::string, int> map { { "hp", 16 }, { "mp", 7 } };
+	std::cout << map << "\n";
+}
+
+TEST_CASE("flat_hash_map randomised insert and erase", "[flat_hash_map]") {
+	std::default_random_engine engine { 0 };
+	std::uniform_int_distribution<int> keys { 0, 2000 };
+	flat_hash_map<int, int> map { -1 };
+	std::map<int, int> reference;
+
+	for (int i = 0; i < 20000; ++i) {
+		const int key = keys(engine);
+		if (reference.count(key)) {
+			CHECK(map.erase(key) == 1);
+			reference.erase(key);
+		}
+		else {
+			map.insert(key, i);
+			reference[key] = i;
+		}
+		if (i % 500 == 0) {
+			REQUIRE(map.size() == reference.size());
+			for (const auto& kv : reference) REQUIRE(map[kv.first] == kv.second);
+			for (int k = 2001; k < 2010; ++k) REQUIRE_FALSE(map.has(k));
+		}
+	}
+}
+
+TEST_CASE("flat_hash_map (benchmarks)", "[!benchmark][flat_hash_map]") {
+	static const int num_keys = 1 << 16;
+	std::default_random_engine engine { 0 };
+	std::uniform_int_distribution<int> distribution;
+	std::vector<int> keys(num_keys), absent(num_keys);
+	for (auto& key : keys) key = distribution(engine) | 1;
+	for (auto& key : absent) key = distribution(engine) & ~1;
+	std::vector<std::string> string_keys;
+	for (int key : keys) string_keys.push_back("key-" + std::to_string(key));
+
+	BENCHMARK("insert: flat_hash_map") {
+		flat_hash_map<int, int> map;
+		for (int key : keys) map.insert(key, key);
+		CHECK(map.size() > 0);
+	}
+
+	BENCHMARK("insert: std::unordered_map") {
+		std::unordered_map<int, int> map;
+		for (int key : keys) map.emplace(key, key);
+		CHECK(map.size() > 0);
+	}
+
+	BENCHMARK("insert after reserve: flat_hash_map") {
+		flat_hash_map<int, int> map;
+		map.reserve(num_keys);
+		for (int key : keys) map.insert(key, key);
+		CHECK(map.size() > 0);
+	}
+
+	BENCHMARK("insert after reserve: std::unordered_map") {
+		std::unordered_map<int, int> map;
+		map.reserve(num_keys);
+		for (int key : keys) map.emplace(key, key);
+		CHECK(map.size() > 0);
+	}
+
+	flat_hash_map<int, int> flat;
+	std::unordered_map<int, int> unordered;
+	for (int key : keys) {
+		flat.insert(key, key);
+		unordered.emplace(key, key);
+	}
+
+	BENCHMARK("hits: flat_hash_map") {
+		int found = 0;
+		for (int key : keys) found += flat.has(key);
+		CHECK(found == num_keys);
+	}
+
+	BENCHMARK("hits: std::unordered_map") {
+		int found = 0;
+		for (int key : keys) found += static_cast<int>(unordered.count(key));
+		CHECK(found == num_keys);
+	}
+
+	BENCHMARK("misses: flat_hash_map") {
+		int found = 0;
+		for (int key : absent) found += flat.has(key);
+		CHECK(found == 0);
+	}
+
+	BENCHMARK("misses: std::unordered_map") {
+		int found = 0;
+		for (int key : absent) found += static_cast<int>(unordered.count(key));
+		CHECK(found == 0);
+	}
+
+	// Swaps every key for an absent one and back, so each run starts from the same keys
+	BENCHMARK("churn: flat_hash_map") {
+		for (int i = 0; i < num_keys; ++i) {
+			flat.erase(keys[i]);
+			flat.insert(absent[i], i);
+		}
+		for (int i = 0; i < num_keys; ++i) {
+			flat.erase(absent[i]);
+			flat.insert(keys[i], i);
+		}
+		CHECK(flat.size() == unordered.size());
+	}
+
+	BENCHMARK("churn: std::unordered_map") {
+		for (int i = 0; i < num_keys; ++i) {
+			unordered.erase(keys[i]);
+			unordered.emplace(absent[i], i);
+		}
+		for (int i = 0; i < num_keys; ++i) {
+			unordered.erase(absent[i]);
+			unordered.emplace(keys[i], i);
+		}
+		CHECK(unordered.size() == flat.size());
+	}
+
+	flat_hash_map<std::string, int> flat_strings;
+	std::unordered_map<std::string, int> unordered_strings;
+	for (const auto& key : string_keys) {
+		flat_strings.insert(key, 1);
+		unordered_strings.emplace(key, 1);
+	}
+
+	BENCHMARK("string hits: flat_hash_map") {
+		int found = 0;
+		for (const auto& key : string_keys) found += flat_strings.has(key);
+		CHECK(found == num_keys);
+	}
+
+	BENCHMARK("string hits: std::unordered_map") {
+		int found = 0;
+		for (const auto& key : string_keys) found += static_cast<int>(unordered_strings.count(key));
+		CHECK(found == num_keys);
+	}
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/mirrored_ring_buffer.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+#if defined(__linux__)
+
+using bsp::mirrored_ring_buffer;
+using Catch::Equals;
+
+static std::string to_string(const mirrored_ring_buffer& ring) {
+	return std::string(ring.begin(), ring.end());
+}
+
+TEST_CASE("mirrored_ring_buffer basics", "[mirrored_ring_buffer]") {
+	mirrored_ring_buffer ring { 100 };
+	CHECK(ring.empty());
+	CHECK(ring.max_size() >= 100);
+	CHECK((ring.max_size() & (ring.max_size() - 1)) == 0);
+
+	SECTION("push_back and pop_front") {
+		ring.push_back('a');
+		ring.push_back('b');
+		CHECK(ring.count() == 2);
+		CHECK(ring.front() == 'a');
+		CHECK(ring.back() == 'b');
+		ring.pop_front();
+		CHECK(ring.front() == 'b');
+	}
+
+	SECTION("push_back overwrites when full") {
+		for (int i = 0; i < ring.max_size() + 3; ++i) ring.push_back(static_cast<std::uint8_t>(i));
+		CHECK(ring.count() == ring.max_size());
+		CHECK(ring.front() == 3);
+	}
+
+	SECTION("push_back_n") {
+		ring.push_back_n("hello", 5);
+		ring.push_back_n(" world", 6);
+		CHECK(to_string(ring) == "hello world");
+		ring.pop_front_n(6);
+		CHECK(to_string(ring) == "world");
+	}
+
+	SECTION("clear") {
+		ring.push_back_n("hello", 5);
+		ring.clear();
+		CHECK(ring.empty());
+	}
+}
+
+TEST_CASE("mirrored_ring_buffer is contiguous across the wrap point", "[mirrored_ring_buffer]") {
+	mirrored_ring_buffer ring { 4096 };
+	const int capacity = ring.max_size();
+
+	// Move the cursors to just before the end of the mapping
+	std::vector<std::uint8_t> filler(capacity - 3, 'x');
+	ring.push_back_n(filler.data(), (int) filler.size());
+	ring.pop_front_n((int) filler.size());
+	REQUIRE(ring.start() == capacity - 3);
+
+	ring.push_back_n("GET /index.html", 15);
+	CHECK(ring.count() == 15);
+	const std::uint8_t* header = ring.peek(15);
+	REQUIRE(header != nullptr);
+	CHECK(std::string(header, header + 15) == "GET /index.html");
+	CHECK(ring.peek(16) == nullptr);
+	CHECK(ring[14] == 'l');
+
+	SECTION("write_data and commit_push_back") {
+		CHECK(ring.free_count() == capacity - 15);
+		std::memcpy(ring.write_data(), " HTTP/1.1", 9);
+		ring.commit_push_back(9);
+		CHECK(to_string(ring) == "GET /index.html HTTP/1.1");
+	}
+
+	SECTION("push_back_n more than capacity keeps the newest bytes") {
+		std::vector<std::uint8_t> bytes(capacity + 10);
+		for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<std::uint8_t>(i);
+		ring.push_back_n(bytes.data(), (int) bytes.size());
+		CHECK(ring.count() == capacity);
+		CHECK(std::equal(ring.begin(), ring.end(), bytes.begin() + 10));
+	}
+}
+
+TEST_CASE("mirrored_ring_buffer move", "[mirrored_ring_buffer]") {
+	mirrored_ring_buffer ring { 16 };
+	ring.push_back_n("abc", 3);
+	mirrored_ring_buffer ring2 { std::move(ring) };
+	CHECK(to_string(ring2) == "abc");
+
+	mirrored_ring_buffer ring3 { 16 };
+	ring3 = std::move(ring2);
+	CHECK(to_string(ring3) == "abc");
+
+	std::ostringstream oss;
+	oss << ring3;
+	CHECK_THAT(oss.str(), Catch::EndsWith("{3 bytes}"));
+}
+
+TEST_CASE("mirrored_ring_buffer errors", "[mirrored_ring_buffer]") {
+	CHECK_THROWS_AS(mirrored_ring_buffer(0), std::length_error);
+}
+
+#endif
@@ -819,3 +819,184 @@ TEST_CASE("object_pool (iteration stops early)", "[object_pool]") {
 	}
 }
 
+
+struct dirty_hero_policy {
+	static const bool store_id_in_object = false;
+	static const bool shrink_after_clear = false;
+	static const bool track_dirty_objects = true;
+	static bool is_object_iterable(const hero&) { return true; }
+	static void set_object_id(hero&, const uint32_t&) {}
+	static uint32_t get_object_id(const hero&) { return 0; }
+};
+
+TEST_CASE("object_pool (dirty tracking)", "[object_pool]") {
+	object_pool<hero, uint32_t, dirty_hero_policy> pool{ 64 };
+	auto batman = pool.construct("batman", 5, 3).first;
+	auto superman = pool.construct("superman", 9, 2).first;
+	auto flash = pool.construct("flash", 3, 4).first;
+
+	auto consume_names = [&pool]() {
+		std::vector<std::string> names;
+		pool.consume_dirty([&names](const hero& h) { names.push_back(h.name); });
+		return names;
+	};
+
+	SECTION("new objects are dirty") {
+		CHECK(pool.is_dirty(batman));
+		CHECK_THAT(consume_names(), Equals(std::vector<std::string>{ "batman", "superman", "flash" }));
+		CHECK(!pool.is_dirty(batman));
+		CHECK(consume_names().empty());
+	}
+
+	SECTION("mark_dirty") {
+		pool.clear_dirty();
+		pool.mark_dirty(flash);
+		CHECK(pool.is_dirty(flash));
+		CHECK(!pool.is_dirty(superman));
+		CHECK_THAT(consume_names(), Equals(std::vector<std::string>{ "flash" }));
+	}
+
+	SECTION("dirty bit follows object through remove") {
+		pool.clear_dirty();
+		pool.mark_dirty(flash);
+		pool.remove(batman); // flash moves into batman's slot
+		CHECK(pool.is_dirty(flash));
+		CHECK(!pool.is_dirty(superman));
+		CHECK_THAT(consume_names(), Equals(std::vector<std::string>{ "flash" }));
+
+		pool.mark_dirty(superman);
+		pool.remove(flash);
+		CHECK_THAT(consume_names(), Equals(std::vector<std::string>{ "superman" }));
+	}
+
+	SECTION("removing the back object clears its bit") {
+		pool.clear_dirty();
+		pool.mark_dirty(flash);
+		pool.remove(flash);
+		CHECK(consume_names().empty());
+	}
+
+	SECTION("grows with the pool") {
+		pool.clear_dirty();
+		std::vector<uint32_t> ids;
+		for (int i = 0; i < 200; ++i) ids.push_back(pool.construct("robin", i + 1, 0).first);
+		pool.clear_dirty();
+		pool.mark_dirty(ids[150]);
+		pool.mark_dirty(ids[3]);
+		int visited = 0;
+		pool.consume_dirty([&visited](hero& h) { visited += h.hp; });
+		CHECK(visited == 151 + 4);
+	}
+}
+
+TEST_CASE("object_pool (dirty tracking benchmarks)", "[!benchmark]") {
+	static const int num_objects = 16384;
+	object_pool<hero, uint32_t, dirty_hero_policy> pool{ 1024 };
+	std::vector<uint32_t> ids;
+	for (int i = 0; i < num_objects; ++i) ids.push_back(pool.construct("robin", 1, 1).first);
+	pool.clear_dirty();
+
+	BENCHMARK("consume 1% dirty") {
+		for (int i = 0; i < num_objects; i += 100) pool.mark_dirty(ids[i]);
+		volatile int sum = 0;
+		pool.consume_dirty([&sum](const hero& h) { sum = sum + h.hp; });
+	}
+
+	BENCHMARK("iterate all (baseline)") {
+		volatile int sum = 0;
+		for (const auto& h : pool) sum = sum + h.hp;
+	}
+}
+
+struct iterable_hero_policy {
+	static const bool store_id_in_object = false;
+	static const bool shrink_after_clear = false;
+	static const bool track_iterable_objects = true;
+	static bool is_object_iterable(const hero& value) { return value.hp != 0; }
+	static void set_object_id(hero&, const uint32_t&) {}
+	static uint32_t get_object_id(const hero&) { return 0; }
+};
+
+TEST_CASE("object_pool (iterable tracking)", "[object_pool]") {
+	using hero_pool = object_pool<hero, uint32_t, iterable_hero_policy>;
+	hero_pool heroes{ 64 };
+
+	auto names = [](const hero_pool& pool) {
+		std::vector<std::string> result;
+		for (const auto& h : pool) result.push_back(h.name);
+		return result;
+	};
+
+	SECTION("empty") {
+		CHECK(heroes.begin() == heroes.end());
+	}
+
+	SECTION("evaluates policy on construction") {
+		heroes.construct("superman", 0, 3);
+		auto batman = heroes.construct("batman", 5, 3).first;
+		heroes.construct("spiderman", 0, 3);
+		heroes.construct("flash", 3, 4);
+		CHECK(heroes.is_iterable(batman));
+		CHECK_THAT(names(heroes), Equals(std::vector<std::string>{ "batman", "flash" }));
+	}
+
+	SECTION("set_iterable and update_iterable") {
+		auto superman = heroes.construct("superman", 0, 3).first;
+		auto batman = heroes.construct("batman", 5, 3).first;
+		heroes.set_iterable(superman, true);
+		heroes.set_iterable(batman, false);
+		CHECK_THAT(names(heroes), Equals(std::vector<std::string>{ "superman" }));
+
+		heroes[superman].hp = 0;
+		heroes[batman].hp = 1;
+		heroes.update_iterable(superman);
+		heroes.update_iterable(batman);
+		CHECK_THAT(names(heroes), Equals(std::vector<std::string>{ "batman" }));
+	}
+
+	SECTION("iterable bit follows object through remove") {
+		auto batman = heroes.construct("batman", 5, 3).first;
+		heroes.construct("superman", 0, 3);
+		heroes.construct("flash", 3, 4);
+		heroes.remove(batman); // flash moves into batman's slot
+		CHECK_THAT(names(heroes), Equals(std::vector<std::string>{ "flash" }));
+	}
+
+	SECTION("iterates across storages") {
+		std::vector<std::string> expected;
+		for (int i = 0; i < 300; ++i) {
+			bool visible = (i % 7) == 0;
+			heroes.construct(visible ? "visible" : "hidden", visible ? 1 : 0, i);
+			if (visible) expected.push_back("visible");
+		}
+		CHECK(heroes.objects().storage_count() > 1);
+		CHECK_THAT(names(heroes), Equals(expected));
+
+		int sum_mp = 0;
+		for (const auto& h : heroes) sum_mp += h.mp;
+		int expected_mp = 0;
+		for (int i = 0; i < 300; i += 7) expected_mp += i;
+		CHECK(sum_mp == expected_mp);
+	}
+}
+
+TEST_CASE("object_pool (iterable tracking benchmarks)", "[!benchmark]") {
+	static const int num_objects = 16384;
+	object_pool<hero, uint32_t, hero_policy> filtered{ 1024 };
+	object_pool<hero, uint32_t, iterable_hero_policy> tracked{ 1024 };
+	for (int i = 0; i < num_objects; ++i) {
+		int hp = (i % 10 == 0) ? 1 : 0; // 90% filtered out
+		filtered.construct("robin", hp, 1);
+		tracked.construct("robin", hp, 1);
+	}
+
+	BENCHMARK("iterate 10% (is_object_iterable per element)") {
+		volatile int sum = 0;
+		for (const auto& h : filtered) sum = sum + h.mp;
+	}
+
+	BENCHMARK("iterate 10% (iterable bitmap)") {
+		volatile int sum = 0;
+		for (const auto& h : tracked) sum = sum + h.mp;
+	}
+}
@@ -0,0 +1,207 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/persistent_ring_buffer.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+#if defined(__linux__)
+
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using bsp::persistent_ring_buffer;
+using Catch::Equals;
+
+// A unique path that is removed again at the end of the test
+struct temp_path {
+	std::string path;
+
+	temp_path() {
+		char name[] = "/tmp/bsp_persistent_ring_buffer_XXXXXX";
+		const int fd = mkstemp(name);
+		if (fd != -1) close(fd);
+		path = name;
+		std::remove(path.c_str()); // Start from a missing file
+	}
+
+	~temp_path() { std::remove(path.c_str()); }
+};
+
+struct event {
+	std::uint64_t sequence;
+	std::int32_t code;
+
+	bool operator==(const event& other) const { return sequence == other.sequence && code == other.code; }
+};
+
+std::ostream& operator<<(std::ostream& out, const event& e) { return out << e.sequence << ":" << e.code; }
+
+TEST_CASE("persistent_ring_buffer basics", "[persistent_ring_buffer]") {
+	temp_path file;
+	persistent_ring_buffer<int> ring(file.path, 4);
+	CHECK(ring.empty());
+	CHECK(ring.max_size() == 4);
+
+	for (int i = 1; i <= 3; ++i) ring.push_back(i);
+	CHECK(ring.count() == 3);
+	CHECK(ring.front() == 1);
+	CHECK(ring.back() == 3);
+
+	SECTION("overwrites the oldest record when full") {
+		for (int i = 4; i <= 6; ++i) ring.push_back(i);
+		CHECK(ring.count() == 4);
+		CHECK(ring.total_pushed() == 6);
+		CHECK(ring[0] == 3);
+		CHECK(ring[3] == 6);
+		CHECK_THAT(persistent_ring_buffer<int>::recover(file.path), Equals(std::vector<int>{ 3, 4, 5, 6 }));
+	}
+
+	SECTION("clear") {
+		ring.clear();
+		CHECK(ring.empty());
+		CHECK(persistent_ring_buffer<int>::recover(file.path).empty());
+	}
+
+	SECTION("operator<<") {
+		std::ostringstream oss;
+		oss << ring;
+		CHECK(oss.str() == "persistent_ring_buffer<4> {3 records}");
+	}
+
+	SECTION("a moved-from ring is empty until assigned to") {
+		persistent_ring_buffer<int> moved(std::move(ring));
+		CHECK(moved.count() == 3);
+		CHECK(ring.empty());
+		CHECK(ring.count() == 0);
+		CHECK(ring.max_size() == 0);
+		CHECK(ring.total_pushed() == 0);
+		CHECK_THROWS_AS(ring.push_back(4), std::logic_error);
+		ring.clear();
+		ring.flush();
+
+		ring = std::move(moved);
+		ring.push_back(4);
+		CHECK(ring.count() == 4);
+		CHECK(ring.back() == 4);
+	}
+}
+
+TEST_CASE("persistent_ring_buffer reopens", "[persistent_ring_buffer]") {
+	temp_path file;
+	{
+		persistent_ring_buffer<int> ring(file.path, 3);
+		for (int i = 0; i < 5; ++i) ring.push_back(i);
+		ring.flush();
+	}
+
+	SECTION("resumes where it left off") {
+		persistent_ring_buffer<int> ring(file.path, 3);
+		CHECK(ring.count() == 3);
+		CHECK(ring.front() == 2);
+		ring.push_back(5);
+		CHECK_THAT(persistent_ring_buffer<int>::recover(file.path), Equals(std::vector<int>{ 3, 4, 5 }));
+	}
+
+	SECTION("rejects a different layout") {
+		CHECK_THROWS_AS(persistent_ring_buffer<int>(file.path, 4), std::runtime_error);
+		CHECK_THROWS_AS(persistent_ring_buffer<std::int64_t>(file.path, 3), std::runtime_error);
+		CHECK_THROWS_AS(persistent_ring_buffer<std::int64_t>::recover(file.path), std::runtime_error);
+	}
+}
+
+TEST_CASE("persistent_ring_buffer invalid files", "[persistent_ring_buffer]") {
+	temp_path file;
+	CHECK_THROWS_AS(persistent_ring_buffer<int>(file.path, 0), std::length_error);
+	CHECK_THROWS_AS(persistent_ring_buffer<int>::recover(file.path), std::system_error);
+
+	{
+		std::ofstream out(file.path);
+		out << "not a ring buffer";
+	}
+	CHECK_THROWS_AS(persistent_ring_buffer<int>::recover(file.path), std::runtime_error);
+	CHECK_THROWS_AS(persistent_ring_buffer<int>(file.path, 4), std::runtime_error);
+}
+
+// Trivially copyable without a default constructor
+struct reading {
+	explicit reading(int v) : value(v) {}
+	int value;
+};
+
+TEST_CASE("persistent_ring_buffer creation", "[persistent_ring_buffer]") {
+	temp_path file;
+
+	SECTION("an empty file is initialised") {
+		{ std::ofstream out(file.path); }
+		persistent_ring_buffer<int> ring(file.path, 4);
+		CHECK(ring.empty());
+		ring.push_back(7);
+		CHECK_THAT(persistent_ring_buffer<int>::recover(file.path), Equals(std::vector<int>{ 7 }));
+	}
+
+	SECTION("a new log has a header and the usual permissions") {
+		{ persistent_ring_buffer<int> ring(file.path, 4); }
+		CHECK(persistent_ring_buffer<int>::recover(file.path).empty());
+		struct stat st;
+		REQUIRE(stat(file.path.c_str(), &st) == 0);
+		CHECK((st.st_mode & 0777) == 0644);
+	}
+
+	SECTION("records need not be default constructible") {
+		persistent_ring_buffer<reading> ring(file.path, 2);
+		for (int i = 0; i < 3; ++i) ring.push_back(reading(i));
+		const std::vector<reading> readings = persistent_ring_buffer<reading>::recover(file.path);
+		REQUIRE(readings.size() == 2);
+		CHECK(readings[0].value == 1);
+		CHECK(readings[1].value == 2);
+	}
+}
+
+TEST_CASE("persistent_ring_buffer recovers after a crash", "[persistent_ring_buffer]") {
+	temp_path file;
+	const int capacity = 1000;
+	const int num_events = 4321;
+
+	// The child logs events then dies without unmapping or flushing anything
+	const pid_t child = fork();
+	REQUIRE(child != -1);
+	if (child == 0) {
+		persistent_ring_buffer<event> ring(file.path, capacity);
+		for (int i = 0; i < num_events; ++i) ring.push_back(event { static_cast<std::uint64_t>(i), i * 3 });
+		kill(getpid(), SIGKILL);
+	}
+	int status = 0;
+	REQUIRE(waitpid(child, &status, 0) == child);
+	CHECK(WIFSIGNALED(status));
+	CHECK(WTERMSIG(status) == SIGKILL);
+
+	const std::vector<event> events = persistent_ring_buffer<event>::recover(file.path);
+	REQUIRE(events.size() == (std::size_t) capacity);
+	for (int i = 0; i < capacity; ++i) {
+		const int expected = num_events - capacity + i;
+		CHECK(events[i] == (event { static_cast<std::uint64_t>(expected), expected * 3 }));
+	}
+}
+
+TEST_CASE("persistent_ring_buffer (benchmarks)", "[!benchmark][persistent_ring_buffer]") {
+	temp_path file;
+	static const int num_events = 1 << 20;
+	persistent_ring_buffer<event> ring(file.path, 4096);
+
+	BENCHMARK("push_back: 1M events") {
+		for (int i = 0; i < num_events; ++i) ring.push_back(event { static_cast<std::uint64_t>(i), i });
+	}
+}
+
+#endif // defined(__linux__)
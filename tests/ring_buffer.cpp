@@ -1,12 +1,16 @@
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -315,4 +319,689 @@ TEST_CASE("ring_buffer operator<<", "[ring_buffer]"){
         std::cout << "Should print {_, _, 3, 4}\n";
         std::cout << ring << "\n";
     }
-}
\ No newline at end of file
+}
+TEST_CASE("ring_buffer non power of two capacity", "[ring_buffer]"){
+    SECTION("add beyond max_size()"){
+        ring_buffer<int, 5> ring;
+        for (int i=0; i<7; i++) ring.push_back(i);
+        CHECK(ring.start() == 2);
+        CHECK(ring.count() == 5);
+        CHECK(ring.front() == 2);
+        CHECK(ring.back() == 6);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{2, 3, 4, 5, 6}));
+    }
+
+    SECTION("pushing and popping"){
+        ring_buffer<int, 5> ring;
+        for (int i=0; i<23; i++){
+            ring.push_back(i);
+            ring.push_back(i);
+            CHECK(ring.back() == i);
+            ring.pop_front();
+            CHECK(ring.count() == std::min<int>(i + 1, ring.max_size() - 1));
+        }
+    }
+
+    SECTION("valid_index"){
+        ring_buffer<int, 5> ring;
+        for (int i=0; i<7; i++) ring.push_back(i);
+        ring.pop_front();
+        ring.pop_front();
+        CHECK(!ring.valid_index(2));
+        CHECK(!ring.valid_index(3));
+        CHECK(ring.valid_index(4));
+        CHECK(ring.valid_index(0));
+        CHECK(ring.valid_index(1));
+    }
+
+    SECTION("reverse iterator"){
+        ring_buffer<int, 5> ring { 1, 2, 3, 4, 5, 6, 7 };
+        std::vector<int> reversed { ring.rbegin(), ring.rend() };
+        CHECK_THAT(reversed, Equals(std::vector<int>{7, 6, 5, 4, 3}));
+    }
+}
+
+// Starts the free-running cursors just below their maximum value
+struct ring_buffer_near_wrap : ring_buffer<int, 4> {
+    ring_buffer_near_wrap(){ head_ = tail_ = 0xfffffffeu; }
+};
+
+TEST_CASE("ring_buffer power of two cursors wrap", "[ring_buffer]"){
+    ring_buffer_near_wrap ring;
+    CHECK(ring.empty());
+    for (int i=0; i<6; i++) ring.push_back(i);
+    CHECK(ring.count() == 4);
+    CHECK(ring.front() == 2);
+    CHECK(ring.back() == 5);
+    CHECK_THAT(ring, Equals(ring, std::vector<int>{2, 3, 4, 5}));
+    ring.pop_front();
+    CHECK(ring.count() == 3);
+    CHECK(ring.valid_index(ring.start()));
+}
+
+// Reference for the benchmarks: the original ring_buffer indexing, which wraps every index with a modulo
+template <typename T, int Capacity> class modulo_ring_buffer {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const modulo_ring_buffer& ring, int i) : ring_(ring), i_(i) {}
+        const T& operator*() const { return ring_.data_[(ring_.start_ + i_) % Capacity]; }
+        const_iterator& operator++(){ ++i_; return *this; }
+        bool operator!=(const const_iterator& other) const { return i_ != other.i_; }
+    private:
+        const modulo_ring_buffer& ring_;
+        int i_;
+    };
+
+    void push_back(const T& value){
+        data_[(start_ + count_) % Capacity] = value;
+        if (count_ == Capacity) start_ = (start_ + 1) % Capacity;
+        else count_++;
+    }
+
+    void pop_front(){
+        assert(count_ > 0);
+        start_ = (start_ + 1) % Capacity;
+        count_--;
+    }
+
+    const_iterator begin() const { return const_iterator(*this, 0); }
+    const_iterator end() const { return const_iterator(*this, count_); }
+
+private:
+    T data_[Capacity] = {};
+    int start_ = 0;
+    int count_ = 0;
+};
+
+template <typename Ring> static void benchmark_ring_buffer_throughput(Ring& ring, int num_samples){
+    for (int i=0; i<num_samples; i++){
+        ring.push_back(i);
+        if (i & 1) ring.pop_front();
+    }
+}
+
+template <typename Ring> static int benchmark_ring_buffer_iterate(const Ring& ring){
+    int sum = 0;
+    for (int x: ring) sum += x;
+    return sum;
+}
+
+TEST_CASE("ring_buffer (benchmarks)", "[!benchmark][ring_buffer]"){
+    static const int num_samples = 1 << 20;
+    modulo_ring_buffer<int, 1000> modulo_ring;
+    ring_buffer<int, 1000> compare_ring;
+    ring_buffer<int, 1024> mask_ring;
+
+    BENCHMARK("push/pop: capacity 1000 (modulo reference)"){
+        benchmark_ring_buffer_throughput(modulo_ring, num_samples);
+    }
+
+    BENCHMARK("push/pop: capacity 1000 (compare)"){
+        benchmark_ring_buffer_throughput(compare_ring, num_samples);
+    }
+
+    BENCHMARK("push/pop: capacity 1024 (mask)"){
+        benchmark_ring_buffer_throughput(mask_ring, num_samples);
+    }
+
+    for (int i=0; i<1024; i++) { modulo_ring.push_back(i); compare_ring.push_back(i); mask_ring.push_back(i); }
+    volatile int sink = 0;
+
+    BENCHMARK("iterate: capacity 1000 (modulo reference)"){
+        for (int i=0; i<1024; i++) sink = sink + benchmark_ring_buffer_iterate(modulo_ring);
+    }
+
+    BENCHMARK("iterate: capacity 1000 (compare)"){
+        for (int i=0; i<1024; i++) sink = sink + benchmark_ring_buffer_iterate(compare_ring);
+    }
+
+    BENCHMARK("iterate: capacity 1024 (mask)"){
+        for (int i=0; i<1024; i++) sink = sink + benchmark_ring_buffer_iterate(mask_ring);
+    }
+}
+
+TEST_CASE("ring_buffer bulk operations", "[ring_buffer]"){
+    SECTION("push_back_n"){
+        ring_buffer<int, 8> ring { 1, 2, 3 };
+        std::vector<int> values { 4, 5, 6 };
+        ring.push_back_n(values.begin(), 3);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{1, 2, 3, 4, 5, 6}));
+    }
+
+    SECTION("push_back_n wraps and overwrites"){
+        ring_buffer<int, 5> ring { 1, 2, 3, 4 };
+        std::vector<int> values { 5, 6, 7 };
+        ring.push_back_n(values.begin(), 3);
+        CHECK(ring.count() == 5);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5, 6, 7}));
+    }
+
+    SECTION("push_back_n more than capacity"){
+        ring_buffer<int, 4> ring { 1 };
+        std::vector<int> values { 2, 3, 4, 5, 6, 7 };
+        ring.push_back_n(values.begin(), 6);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{4, 5, 6, 7}));
+    }
+
+    SECTION("pop_front_n"){
+        ring_buffer<int, 5> ring { 1, 2, 3, 4, 5, 6, 7 };
+        ring.pop_front_n(2);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{5, 6, 7}));
+    }
+
+    SECTION("pop_front_n into output"){
+        ring_buffer<int, 5> ring { 1, 2, 3, 4, 5, 6, 7 };
+        std::vector<int> out;
+        ring.pop_front_n(std::back_inserter(out), 4);
+        CHECK_THAT(out, Equals(std::vector<int>{3, 4, 5, 6}));
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{7}));
+    }
+}
+
+TEST_CASE("ring_buffer segments", "[ring_buffer]"){
+    SECTION("empty"){
+        ring_buffer<int, 8> ring;
+        auto r = ring.read_segments();
+        CHECK(r[0].empty());
+        CHECK(r[1].empty());
+        auto w = ring.write_segments();
+        CHECK(w[0].size() == 8);
+        CHECK(w[1].empty());
+    }
+
+    SECTION("contiguous"){
+        const ring_buffer<int, 8> ring { 1, 2, 3 };
+        auto r = ring.read_segments();
+        CHECK_THAT(std::vector<int>(r[0].begin(), r[0].end()), Equals(std::vector<int>{1, 2, 3}));
+        CHECK(r[1].empty());
+    }
+
+    SECTION("wrapped"){
+        ring_buffer<int, 5> ring { 1, 2, 3, 4, 5, 6, 7 };
+        ring.pop_front();
+        auto r = ring.read_segments();
+        CHECK_THAT(std::vector<int>(r[0].begin(), r[0].end()), Equals(std::vector<int>{4, 5}));
+        CHECK_THAT(std::vector<int>(r[1].begin(), r[1].end()), Equals(std::vector<int>{6, 7}));
+
+        auto w = ring.write_segments();
+        CHECK(w[0].size() == 1);
+        CHECK(w[1].size() == 0);
+        CHECK(w[0].data() == &ring[2]);
+    }
+
+    SECTION("write and commit"){
+        ring_buffer<int, 4> ring { 1, 2, 3 };
+        ring.pop_front_n(2);
+        auto w = ring.write_segments();
+        REQUIRE(w[0].size() == 1);
+        REQUIRE(w[1].size() == 2);
+        w[0].data()[0] = 4;
+        w[1].data()[0] = 5;
+        ring.commit_push_back(2);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5}));
+    }
+}
+
+TEST_CASE("ring_buffer bulk (benchmarks)", "[!benchmark][ring_buffer]"){
+    static const int num_samples = 1 << 20;
+    static const int block = 256;
+    ring_buffer<float, 1024> ring;
+    std::vector<float> input(block, 1.0f), output(block);
+
+    BENCHMARK("push_back/pop_front one at a time"){
+        for (int i = 0; i < num_samples; i += block){
+            for (int j = 0; j < block; j++) ring.push_back(input[j]);
+            for (int j = 0; j < block; j++) { output[j] = ring.front(); ring.pop_front(); }
+        }
+    }
+
+    BENCHMARK("push_back_n/pop_front_n"){
+        for (int i = 0; i < num_samples; i += block){
+            ring.push_back_n(input.data(), block);
+            ring.pop_front_n(output.data(), block);
+        }
+    }
+}
+
+// Counts live instances to check ring_buffer constructs and destroys slots correctly
+struct ring_buffer_tracked {
+    static int live;
+    int value;
+    explicit ring_buffer_tracked(int value):value(value){ live++; }
+    ring_buffer_tracked(const ring_buffer_tracked& other):value(other.value){ live++; }
+    ring_buffer_tracked& operator=(const ring_buffer_tracked&) = default;
+    ~ring_buffer_tracked(){ live--; }
+};
+
+int ring_buffer_tracked::live = 0;
+
+TEST_CASE("ring_buffer uninitialized storage", "[ring_buffer]"){
+    ring_buffer_tracked::live = 0;
+
+    SECTION("doesn't construct unused slots"){
+        ring_buffer<ring_buffer_tracked, 8> ring;
+        CHECK(ring_buffer_tracked::live == 0);
+        ring.emplace_back(1);
+        ring.push_back(ring_buffer_tracked(2));
+        CHECK(ring_buffer_tracked::live == 2);
+        ring.pop_front();
+        CHECK(ring_buffer_tracked::live == 1);
+        CHECK(ring.front().value == 2);
+    }
+
+    SECTION("overwrite keeps one object per slot"){
+        ring_buffer<ring_buffer_tracked, 4> ring;
+        for (int i = 0; i < 10; ++i) ring.emplace_back(i);
+        CHECK(ring_buffer_tracked::live == 4);
+        CHECK(ring.front().value == 6);
+        ring.push_back(ring.front()); // Aliases the slot being overwritten
+        CHECK(ring.back().value == 6);
+        CHECK(ring_buffer_tracked::live == 4);
+    }
+
+    SECTION("bulk operations"){
+        ring_buffer<ring_buffer_tracked, 5> ring;
+        std::vector<ring_buffer_tracked> values;
+        for (int i = 0; i < 7; ++i) values.emplace_back(i);
+        ring.emplace_back(-1);
+        ring.emplace_back(-2);
+        ring.push_back_n(values.begin(), 4);
+        CHECK(ring_buffer_tracked::live == 7 + 5);
+        ring.push_back_n(values.begin() + 4, 3);
+        CHECK(ring_buffer_tracked::live == 7 + 5);
+        CHECK(ring.front().value == 2);
+        ring.pop_front_n(3);
+        CHECK(ring_buffer_tracked::live == 7 + 2);
+    }
+
+    SECTION("clear, copy, move and destruction"){
+        {
+            ring_buffer<ring_buffer_tracked, 4> ring;
+            for (int i = 0; i < 6; ++i) ring.emplace_back(i);
+            const ring_buffer<ring_buffer_tracked, 4>& const_ring = ring;
+            ring_buffer<ring_buffer_tracked, 4> copy { const_ring };
+            CHECK(ring_buffer_tracked::live == 8);
+            CHECK(copy.front().value == 2);
+            CHECK(copy.back().value == 5);
+            ring_buffer<ring_buffer_tracked, 4> moved { std::move(copy) };
+            CHECK(moved.front().value == 2);
+            copy = const_ring;
+            CHECK(copy.back().value == 5);
+            ring.clear();
+            CHECK(ring_buffer_tracked::live == 8);
+        }
+        CHECK(ring_buffer_tracked::live == 0);
+    }
+}
+
+TEST_CASE("ring_buffer at() is relative to front()", "[ring_buffer]"){
+    ring_buffer<int, 4> ring { 1, 2, 3, 4, 5, 6 };
+    CHECK(ring.at(0) == 3);
+    CHECK(ring.at(3) == 6);
+    CHECK_THROWS_AS(ring.at(4), std::out_of_range);
+}
+
+using bsp::dynamic_ring_buffer;
+
+// Counts allocations to check dynamic_ring_buffer allocates once
+template <typename T> struct counting_allocator {
+    using value_type = T;
+    int* allocations;
+    explicit counting_allocator(int* allocations):allocations(allocations){}
+    template <typename U> counting_allocator(const counting_allocator<U>& other):allocations(other.allocations){}
+    T* allocate(std::size_t n){ (*allocations)++; return std::allocator<T>().allocate(n); }
+    void deallocate(T* p, std::size_t n){ std::allocator<T>().deallocate(p, n); }
+    template <typename U> bool operator==(const counting_allocator<U>& rhs) const { return allocations == rhs.allocations; }
+    template <typename U> bool operator!=(const counting_allocator<U>& rhs) const { return allocations != rhs.allocations; }
+};
+
+TEST_CASE("dynamic_ring_buffer basics", "[dynamic_ring_buffer]"){
+    SECTION("runtime capacity"){
+        int capacity = 5;
+        dynamic_ring_buffer<int> ring { capacity };
+        CHECK(ring.max_size() == 5);
+        CHECK(ring.empty());
+        for (int i=0; i<7; i++) ring.push_back(i);
+        CHECK(ring.count() == 5);
+        CHECK(ring.front() == 2);
+        CHECK(ring.back() == 6);
+        CHECK(ring.at(1) == 3);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{2, 3, 4, 5, 6}));
+        ring.pop_front();
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5, 6}));
+        std::vector<int> reversed { ring.rbegin(), ring.rend() };
+        CHECK_THAT(reversed, Equals(std::vector<int>{6, 5, 4, 3}));
+    }
+
+    SECTION("power of two"){
+        dynamic_ring_buffer<int, true> ring { 5 };
+        CHECK(ring.max_size() == 8);
+        for (int i=0; i<11; i++) ring.push_back(i);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5, 6, 7, 8, 9, 10}));
+    }
+
+    SECTION("bulk and segments"){
+        dynamic_ring_buffer<int> ring { 5 };
+        std::vector<int> values { 1, 2, 3, 4, 5, 6, 7 };
+        ring.push_back_n(values.begin(), 7);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5, 6, 7}));
+        ring.pop_front_n(1);
+        auto r = ring.read_segments();
+        CHECK(r[0].size() + r[1].size() == 4);
+    }
+
+    SECTION("copy and move"){
+        dynamic_ring_buffer<std::string> ring { 3 };
+        ring.push_back("a");
+        ring.push_back("b");
+        ring.push_back("c");
+        ring.push_back("d");
+        dynamic_ring_buffer<std::string> copy { ring };
+        CHECK_THAT(copy, Equals(copy, std::vector<std::string>{"b", "c", "d"}));
+        dynamic_ring_buffer<std::string> moved { std::move(copy) };
+        CHECK_THAT(moved, Equals(moved, std::vector<std::string>{"b", "c", "d"}));
+        copy = moved;
+        CHECK(copy.count() == 3);
+    }
+
+    SECTION("moved-from buffers can be copied and reused"){
+        dynamic_ring_buffer<std::string> ring { 2 };
+        ring.push_back("a");
+        dynamic_ring_buffer<std::string> moved { std::move(ring) };
+        CHECK(ring.max_size() == 0);
+        CHECK(ring.empty());
+
+        dynamic_ring_buffer<std::string> copy { ring };
+        CHECK(copy.max_size() == 0);
+        CHECK(copy.empty());
+
+        ring.push_back("b");
+        CHECK(ring.max_size() == 1);
+        CHECK(ring.front() == "b");
+        copy.emplace_back("c");
+        copy.grow();
+        copy.push_back("d");
+        CHECK(copy.max_size() == 2);
+        CHECK_THAT(copy, Equals(copy, std::vector<std::string>{"c", "d"}));
+
+        dynamic_ring_buffer<std::string> bulk { std::move(copy) };
+        std::vector<std::string> values { "e", "f", "g" };
+        copy.push_back_n(values.begin(), 3);
+        CHECK_THAT(copy, Equals(copy, std::vector<std::string>{"g"}));
+    }
+
+    SECTION("errors"){
+        CHECK_THROWS_AS(dynamic_ring_buffer<int>(0), std::length_error);
+        dynamic_ring_buffer<int> ring { 4 };
+        CHECK_THROWS_AS(ring.at(0), std::out_of_range);
+    }
+}
+
+TEST_CASE("dynamic_ring_buffer reserve", "[dynamic_ring_buffer]"){
+    int allocations = 0;
+    using ring_type = dynamic_ring_buffer<std::unique_ptr<int>, false, counting_allocator<std::unique_ptr<int>>>;
+    ring_type ring { 4, counting_allocator<std::unique_ptr<int>>(&allocations) };
+    CHECK(allocations == 1);
+
+    for (int i=0; i<6; i++) ring.emplace_back(new int(i));
+    CHECK(allocations == 1);
+    REQUIRE(ring.start() == 2);
+
+    ring.reserve(3);
+    CHECK(allocations == 1);
+
+    ring.reserve(6);
+    CHECK(allocations == 2);
+    CHECK(ring.max_size() == 6);
+    CHECK(ring.start() == 0);
+    std::vector<int> values;
+    for (const auto& p: ring) values.push_back(*p);
+    CHECK_THAT(values, Equals(std::vector<int>{2, 3, 4, 5}));
+
+    ring.grow();
+    CHECK(ring.max_size() == 12);
+    ring.emplace_back(new int(6));
+    CHECK(*ring.back() == 6);
+    CHECK(ring.count() == 5);
+}
+
+// Copying throws once copies_left runs out, and moving may throw so reserve has to copy
+struct ring_buffer_throwing_copy {
+    static int live;
+    static int copies_left;
+    int value;
+    explicit ring_buffer_throwing_copy(int value):value(value){ live++; }
+    ring_buffer_throwing_copy(const ring_buffer_throwing_copy& other):value(other.value){
+        if (copies_left-- == 0) throw std::runtime_error("copy");
+        live++;
+    }
+    ring_buffer_throwing_copy(ring_buffer_throwing_copy&& other):value(other.value){ other.value = -1; live++; }
+    ring_buffer_throwing_copy& operator=(const ring_buffer_throwing_copy&) = default;
+    ~ring_buffer_throwing_copy(){ live--; }
+};
+
+int ring_buffer_throwing_copy::live = 0;
+int ring_buffer_throwing_copy::copies_left = 0;
+
+TEST_CASE("dynamic_ring_buffer reserve exception safety", "[dynamic_ring_buffer]"){
+    ring_buffer_throwing_copy::live = 0;
+    {
+        dynamic_ring_buffer<ring_buffer_throwing_copy> ring { 4 };
+        for (int i=0; i<6; i++) ring.emplace_back(i);
+        REQUIRE(ring_buffer_throwing_copy::live == 4);
+
+        ring_buffer_throwing_copy::copies_left = 2;
+        CHECK_THROWS_AS(ring.reserve(8), std::runtime_error);
+        CHECK(ring.max_size() == 4);
+        CHECK(ring_buffer_throwing_copy::live == 4);
+        std::vector<int> values;
+        for (const auto& x: ring) values.push_back(x.value);
+        CHECK_THAT(values, Equals(std::vector<int>{2, 3, 4, 5}));
+
+        ring_buffer_throwing_copy::copies_left = 4;
+        ring.reserve(8);
+        CHECK(ring.max_size() == 8);
+        CHECK(ring_buffer_throwing_copy::live == 4);
+        values.clear();
+        for (const auto& x: ring) values.push_back(x.value);
+        CHECK_THAT(values, Equals(std::vector<int>{2, 3, 4, 5}));
+    }
+    CHECK(ring_buffer_throwing_copy::live == 0);
+}
+
+TEST_CASE("dynamic_ring_buffer operator<<", "[dynamic_ring_buffer]"){
+    dynamic_ring_buffer<int> ring { 4 };
+    std::ostringstream oss;
+    oss << ring;
+    ring.push_back(1);
+    ring.push_back(2);
+    oss << ring;
+    CHECK(oss.str() == "dynamic_ring_buffer<4> {}dynamic_ring_buffer<4> {1, 2, _, _}");
+}
+
+TEST_CASE("ring_buffer random access iterators", "[ring_buffer]"){
+    using iterator = ring_buffer<int, 8>::iterator;
+    using const_iterator = ring_buffer<int, 8>::const_iterator;
+    CHECK((std::is_same<std::iterator_traits<iterator>::iterator_category, std::random_access_iterator_tag>::value));
+    CHECK((std::is_same<std::iterator_traits<const_iterator>::iterator_category, std::random_access_iterator_tag>::value));
+
+    // Sorted contents that wrap around the end of the array
+    ring_buffer<int, 8> ring;
+    for (int i = 0; i < 13; ++i) ring.push_back(i * 10);
+    REQUIRE(ring.start() == 5);
+
+    SECTION("arithmetic"){
+        auto it = ring.begin();
+        CHECK(*(it + 3) == 80);
+        CHECK(it[7] == 120);
+        CHECK(ring.end() - ring.begin() == 8);
+        CHECK(std::distance(ring.begin(), ring.end()) == 8);
+        it += 5;
+        CHECK(*it == 100);
+        it -= 2;
+        CHECK(*it == 80);
+        CHECK(*(2 + it) == 100);
+        CHECK(it > ring.begin());
+        CHECK(it <= ring.end());
+        CHECK(ring.end() - 1 == std::prev(ring.end()));
+        CHECK(*(ring.end() - 1) == 120);
+    }
+
+    SECTION("decrementing from end reaches begin"){
+        auto it = ring.end();
+        for (int i = 0; i < 8; ++i) --it;
+        CHECK(it == ring.begin());
+        CHECK(*it == 50);
+    }
+
+    SECTION("binary search"){
+        const auto& const_ring = ring;
+        auto it = std::lower_bound(const_ring.begin(), const_ring.end(), 95);
+        CHECK(*it == 100);
+        CHECK(it - const_ring.begin() == 5);
+        CHECK(std::binary_search(ring.begin(), ring.end(), 80));
+        CHECK(!std::binary_search(ring.begin(), ring.end(), 81));
+        CHECK(std::upper_bound(ring.begin(), ring.end(), 120) == ring.end());
+    }
+
+    SECTION("sort and nth_element"){
+        std::reverse(ring.begin(), ring.end());
+        CHECK(ring.front() == 120);
+        std::nth_element(ring.begin(), ring.begin() + 4, ring.end());
+        CHECK(ring.begin()[4] == 90);
+        std::sort(ring.begin(), ring.end());
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{50, 60, 70, 80, 90, 100, 110, 120}));
+    }
+
+    SECTION("non power of two"){
+        ring_buffer<int, 5> small;
+        for (int i = 0; i < 7; ++i) small.push_back(i);
+        CHECK(*std::lower_bound(small.begin(), small.end(), 4) == 4);
+        CHECK(small.begin()[4] == 6);
+    }
+}
+
+TEST_CASE("ring_buffer random access (benchmarks)", "[!benchmark][ring_buffer]"){
+    ring_buffer<int, 4096> window;
+    for (int i = 0; i < 6000; ++i) window.push_back(i * 3);
+    volatile int sink = 0;
+
+    BENCHMARK("lower_bound over window (1k queries)"){
+        for (int q = 0; q < 1000; ++q) sink = sink + *std::lower_bound(window.begin(), window.end(), 6000 + q * 11);
+    }
+
+    BENCHMARK("linear find_if over window (1k queries)"){
+        for (int q = 0; q < 1000; ++q){
+            const int key = 6000 + q * 11;
+            sink = sink + *std::find_if(window.begin(), window.end(), [key](int x){ return x >= key; });
+        }
+    }
+}
+
+TEST_CASE("ring_buffer pop_back", "[ring_buffer]"){
+    ring_buffer<int, 4> ring { 1, 2, 3, 4, 5, 6 };
+    ring.pop_back();
+    CHECK(ring.back() == 5);
+    CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5}));
+    ring.push_back(7);
+    ring.push_back(8);
+    CHECK_THAT(ring, Equals(ring, std::vector<int>{4, 5, 7, 8}));
+
+    ring_buffer<int, 5> odd { 1, 2, 3, 4, 5, 6 };
+    odd.pop_back();
+    odd.pop_back();
+    CHECK_THAT(odd, Equals(odd, std::vector<int>{2, 3, 4}));
+}
+
+TEST_CASE("ring_buffer overflow policies", "[ring_buffer]"){
+    using bsp::overflow_policy;
+
+    SECTION("overwrite"){
+        ring_buffer<int, 3> ring;
+        for (int i = 1; i <= 5; ++i) CHECK(ring.push_back(i));
+        CHECK(ring.dropped() == 2);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 4, 5}));
+        std::vector<int> values {6, 7};
+        CHECK(ring.push_back_n(values.begin(), 2) == 2);
+        CHECK(ring.dropped() == 4);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{5, 6, 7}));
+    }
+
+    SECTION("reject"){
+        ring_buffer<int, 3, overflow_policy::reject> ring;
+        for (int i = 1; i <= 3; ++i) CHECK(ring.push_back(i));
+        CHECK(!ring.push_back(4));
+        CHECK(!ring.emplace_back(5));
+        CHECK(ring.dropped() == 2);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{1, 2, 3}));
+
+        ring.pop_front();
+        std::vector<int> values {6, 7, 8};
+        CHECK(ring.push_back_n(values.begin(), 3) == 1);
+        CHECK(ring.dropped() == 4);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{2, 3, 6}));
+
+        ring.reset_dropped();
+        CHECK(ring.dropped() == 0);
+    }
+
+    SECTION("drop_newest"){
+        ring_buffer<int, 3, overflow_policy::drop_newest> ring;
+        for (int i = 1; i <= 5; ++i) CHECK(ring.push_back(i));
+        CHECK(ring.dropped() == 2);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{1, 2, 3}));
+        CHECK(ring.emplace_back(6));
+        CHECK(ring.dropped() == 3);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{1, 2, 3}));
+
+        ring.pop_front_n(2);
+        std::vector<int> values {7, 8, 9, 10};
+        CHECK(ring.push_back_n(values.begin(), 4) == 2);
+        CHECK(ring.dropped() == 5);
+        CHECK_THAT(ring, Equals(ring, std::vector<int>{3, 7, 8}));
+    }
+
+    SECTION("non-trivial elements are not leaked"){
+        auto counter = std::make_shared<int>(0);
+        {
+            ring_buffer<std::shared_ptr<int>, 2, overflow_policy::reject> rejecting;
+            ring_buffer<std::shared_ptr<int>, 2, overflow_policy::drop_newest> dropping;
+            for (int i = 0; i < 4; ++i){
+                rejecting.push_back(counter);
+                dropping.push_back(counter);
+            }
+            CHECK(counter.use_count() == 5);
+        }
+        CHECK(counter.use_count() == 1);
+    }
+
+    SECTION("copies keep the counter"){
+        ring_buffer<int, 2, overflow_policy::reject> ring {1, 2, 3};
+        CHECK(ring.dropped() == 1);
+        auto copy = ring;
+        CHECK(copy.dropped() == 1);
+        CHECK_THAT(copy, Equals(copy, std::vector<int>{1, 2}));
+    }
+}
+
+TEST_CASE("ring_buffer overflow policies (benchmarks)", "[!benchmark][ring_buffer]"){
+    static const int num_pushes = 1 << 22;
+    ring_buffer<int, 1000> overwriting;
+    ring_buffer<int, 1000, bsp::overflow_policy::reject> rejecting;
+    ring_buffer<int, 1000, bsp::overflow_policy::drop_newest> dropping;
+
+    BENCHMARK("push_back into a full ring: overwrite"){
+        for (int i = 0; i < num_pushes; ++i) overwriting.push_back(i);
+    }
+
+    BENCHMARK("push_back into a full ring: reject"){
+        for (int i = 0; i < num_pushes; ++i) rejecting.push_back(i);
+    }
+
+    BENCHMARK("push_back into a full ring: drop_newest"){
+        for (int i = 0; i < num_pushes; ++i) dropping.push_back(i);
+    }
+
+    CHECK(overwriting.dropped() + rejecting.dropped() + dropping.dropped() > 0);
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../include/ring_buffer_io.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using bsp::read_from;
+using bsp::ring_buffer;
+using bsp::write_to;
+using Catch::Equals;
+
+// Closes both ends of a pipe or socketpair
+struct fd_pair {
+	int fds[2] = { -1, -1 };
+
+	~fd_pair() {
+		for (int fd : fds) {
+			if (fd != -1) close(fd);
+		}
+	}
+};
+
+template<int N> static std::string to_string(const ring_buffer<std::uint8_t, N>& ring) {
+	return std::string(ring.begin(), ring.end());
+}
+
+// Moves the ring's start so the next transfer wraps around the end of the storage
+template<int N> static void move_start(ring_buffer<std::uint8_t, N>& ring, int n) {
+	for (int i = 0; i < n; ++i) ring.push_back('_');
+	ring.pop_front_n(n);
+}
+
+TEST_CASE("ring_buffer_io pipe", "[ring_buffer_io]") {
+	fd_pair p;
+	REQUIRE(pipe(p.fds) == 0);
+	ring_buffer<std::uint8_t, 8> ring;
+	move_start(ring, 5);
+
+	SECTION("read_from fills both segments") {
+		REQUIRE(write(p.fds[1], "abcdefghij", 10) == 10);
+		CHECK(read_from(p.fds[0], ring) == 8);
+		CHECK(ring.count() == 8);
+		CHECK(to_string(ring) == "abcdefgh");
+
+		SECTION("full ring") {
+			CHECK(read_from(p.fds[0], ring) == -1);
+			CHECK(errno == ENOBUFS);
+		}
+
+		SECTION("appends after a pop") {
+			ring.pop_front_n(3);
+			CHECK(read_from(p.fds[0], ring) == 2);
+			CHECK(to_string(ring) == "defghij");
+		}
+	}
+
+	SECTION("write_to drains both segments") {
+		const std::string message = "0123456";
+		ring.push_back_n(message.begin(), (int) message.size());
+		CHECK(write_to(p.fds[1], ring) == 7);
+		CHECK(ring.empty());
+		char buffer[16] = {};
+		CHECK(read(p.fds[0], buffer, sizeof(buffer)) == 7);
+		CHECK(std::string(buffer) == message);
+		CHECK(write_to(p.fds[1], ring) == 0);
+	}
+
+	SECTION("end of file") {
+		close(p.fds[1]);
+		p.fds[1] = -1;
+		CHECK(read_from(p.fds[0], ring) == 0);
+		CHECK(ring.empty());
+	}
+}
+
+TEST_CASE("ring_buffer_io socketpair", "[ring_buffer_io]") {
+	fd_pair s;
+	REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, s.fds) == 0);
+	REQUIRE(fcntl(s.fds[0], F_SETFL, O_NONBLOCK) == 0);
+	REQUIRE(fcntl(s.fds[1], F_SETFL, O_NONBLOCK) == 0);
+
+	SECTION("would block") {
+		ring_buffer<char, 16> ring;
+		CHECK(read_from(s.fds[0], ring) == -1);
+		CHECK((errno == EAGAIN || errno == EWOULDBLOCK));
+	}
+
+	SECTION("stream through two wrapping rings") {
+		// Send 10000 bytes through small rings so every transfer splits across the wrap point
+		std::vector<std::uint8_t> sent(10000), received;
+		for (std::size_t i = 0; i < sent.size(); ++i) sent[i] = static_cast<std::uint8_t>(i * 7);
+		ring_buffer<std::uint8_t, 61> out, in;
+		std::size_t next = 0;
+		while (received.size() < sent.size()) {
+			const int n = std::min(out.max_size() - out.count(), static_cast<int>(sent.size() - next));
+			out.push_back_n(sent.begin() + next, n);
+			next += n;
+			if (write_to(s.fds[1], out) == -1) REQUIRE((errno == EAGAIN || errno == EWOULDBLOCK));
+			if (read_from(s.fds[0], in) == -1) REQUIRE((errno == EAGAIN || errno == EWOULDBLOCK));
+			in.pop_front_n(std::back_inserter(received), in.count());
+		}
+		CHECK_THAT(received, Equals(sent));
+	}
+}
+
+#endif // defined(__linux__)
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "../include/ring_buffer_simd.h"
+#include "catch.hpp"
+
+using bsp::ring_buffer;
+
+// The reference: one element at a time through the iterators
+template<int N> static float loop_sum(const ring_buffer<float, N>& ring) {
+	float total = 0;
+	for (float x : ring) total += x;
+	return total;
+}
+
+template<int N> static float loop_dot(const ring_buffer<float, N>& ring, const float* weights) {
+	float total = 0;
+	int i = 0;
+	for (float x : ring) total += x * weights[i++];
+	return total;
+}
+
+TEST_CASE("ring_buffer_simd reductions", "[ring_buffer_simd]") {
+	std::default_random_engine engine { 0 };
+	std::uniform_real_distribution<float> distribution { -10.0f, 10.0f };
+	std::vector<float> weights(64);
+	for (auto& w : weights) w = distribution(engine);
+
+	// Every count and start position, so both segments take every length including the tails
+	ring_buffer<float, 37> ring;
+	CHECK(bsp::ring_sum(ring) == 0);
+	CHECK(bsp::ring_dot(ring, weights.data()) == 0);
+	for (int start = 0; start < 37; start += 3) {
+		for (int count = 1; count <= 37; ++count) {
+			ring.clear();
+			for (int i = 0; i < start; ++i) ring.push_back(0);
+			ring.pop_front_n(start);
+			for (int i = 0; i < count; ++i) ring.push_back(distribution(engine));
+
+			CHECK(bsp::ring_sum(ring) == Approx(loop_sum(ring)).margin(1e-3));
+			CHECK(bsp::ring_min(ring) == *std::min_element(ring.begin(), ring.end()));
+			CHECK(bsp::ring_max(ring) == *std::max_element(ring.begin(), ring.end()));
+			CHECK(bsp::ring_dot(ring, weights.data()) == Approx(loop_dot(ring, weights.data())).margin(1e-2));
+		}
+	}
+}
+
+TEST_CASE("ring_buffer_simd scalar kernels", "[ring_buffer_simd]") {
+	std::vector<float> values { 3, -1, 4, 1, -5, 9, 2, -6, 5 };
+	std::vector<float> ones(values.size(), 1.0f);
+	for (int n = 0; n <= (int) values.size(); ++n) {
+		const float* data = values.data();
+		CHECK(bsp::detail_ring_buffer_simd::scalar_sum(data, n) == std::accumulate(data, data + n, 0.0f));
+		CHECK(bsp::detail_ring_buffer_simd::scalar_dot(data, ones.data(), n) == std::accumulate(data, data + n, 0.0f));
+		CHECK(bsp::detail_ring_buffer_simd::scalar_min(data, n, 100.0f) == (n ? *std::min_element(data, data + n) : 100.0f));
+		CHECK(bsp::detail_ring_buffer_simd::scalar_max(data, n, -100.0f) == (n ? *std::max_element(data, data + n) : -100.0f));
+	}
+}
+
+TEST_CASE("ring_buffer_simd (benchmarks)", "[!benchmark][ring_buffer_simd]") {
+	static const int capacity = 4096;
+	static const int num_reductions = 1000;
+	static ring_buffer<float, capacity> ring;
+	static std::vector<float> weights(capacity, 0.5f);
+	ring.clear();
+	for (int i = 0; i < capacity + capacity / 3; ++i) ring.push_back(static_cast<float>(i % 100));
+
+	float result = 0;
+
+	BENCHMARK("sum: iterator loop") {
+		for (int i = 0; i < num_reductions; ++i) result += loop_sum(ring);
+	}
+
+	BENCHMARK("sum: simd segments") {
+		for (int i = 0; i < num_reductions; ++i) result += bsp::ring_sum(ring);
+	}
+
+	BENCHMARK("min/max: iterator loop") {
+		for (int i = 0; i < num_reductions; ++i) {
+			const auto minmax = std::minmax_element(ring.begin(), ring.end());
+			result += *minmax.first + *minmax.second;
+		}
+	}
+
+	BENCHMARK("min/max: simd segments") {
+		for (int i = 0; i < num_reductions; ++i) result += bsp::ring_min(ring) + bsp::ring_max(ring);
+	}
+
+	BENCHMARK("dot: iterator loop") {
+		for (int i = 0; i < num_reductions; ++i) result += loop_dot(ring, weights.data());
+	}
+
+	BENCHMARK("dot: simd segments") {
+		for (int i = 0; i < num_reductions; ++i) result += bsp::ring_dot(ring, weights.data());
+	}
+
+	CHECK(result != 0);
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/sliding_window.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+using bsp::sliding_window;
+using Catch::Equals;
+
+// Recomputes every aggregate from scratch
+struct naive_window {
+	std::vector<double> samples;
+	double sum() const { return std::accumulate(samples.begin(), samples.end(), 0.0); }
+	double mean() const { return sum() / samples.size(); }
+	double variance() const {
+		double m = mean(), v = 0;
+		for (double x : samples) v += (x - m) * (x - m);
+		return v / samples.size();
+	}
+	double min() const { return *std::min_element(samples.begin(), samples.end()); }
+	double max() const { return *std::max_element(samples.begin(), samples.end()); }
+};
+
+TEST_CASE("sliding_window basics", "[sliding_window]") {
+	sliding_window<int, 4> window;
+	CHECK(window.empty());
+	CHECK(window.sum() == 0);
+	CHECK(window.variance() == 0);
+
+	window.push(2);
+	CHECK(window.mean() == 2);
+	CHECK(window.min() == 2);
+	CHECK(window.max() == 2);
+
+	window.push(4);
+	window.push(4);
+	window.push(6);
+	CHECK(window.full());
+	CHECK(window.sum() == 16);
+	CHECK(window.mean() == Approx(4));
+	CHECK(window.variance() == Approx(2));
+	CHECK(window.sample_variance() == Approx(8.0 / 3));
+	CHECK(window.min() == 2);
+	CHECK(window.max() == 6);
+
+	window.push(1); // Evicts 2
+	CHECK(window.count() == 4);
+	CHECK(window.sum() == 15);
+	CHECK(window.min() == 1);
+	CHECK(window.max() == 6);
+	CHECK_THAT(window.samples(), Equals(window.samples(), std::vector<int>{4, 4, 6, 1}));
+
+	window.clear();
+	CHECK(window.empty());
+	window.push(7);
+	CHECK(window.min() == 7);
+	CHECK(window.mean() == 7);
+}
+
+TEST_CASE("sliding_window min and max expire", "[sliding_window]") {
+	sliding_window<int, 3> window;
+	std::vector<int> values { 9, 1, 5, 3, 2, 8, 8, 0, 4, 4, 4 };
+	std::vector<int> mins, maxs;
+	for (int v : values) {
+		window.push(v);
+		mins.push_back(window.min());
+		maxs.push_back(window.max());
+	}
+	CHECK_THAT(mins, Equals(std::vector<int>{ 9, 1, 1, 1, 2, 2, 2, 0, 0, 0, 4 }));
+	CHECK_THAT(maxs, Equals(std::vector<int>{ 9, 9, 9, 5, 5, 8, 8, 8, 8, 4, 4 }));
+}
+
+TEST_CASE("sliding_window matches naive recomputation", "[sliding_window]") {
+	std::default_random_engine engine { 0 };
+	std::normal_distribution<double> distribution { 100.0, 15.0 };
+	sliding_window<double, 50> window;
+	naive_window naive;
+
+	for (int i = 0; i < 2000; ++i) {
+		double x = distribution(engine);
+		window.push(x);
+		naive.samples.push_back(x);
+		if (naive.samples.size() > 50) naive.samples.erase(naive.samples.begin());
+
+		if (i % 97 == 0) {
+			CHECK(window.sum() == Approx(naive.sum()));
+			CHECK(window.mean() == Approx(naive.mean()));
+			CHECK(window.variance() == Approx(naive.variance()));
+			CHECK(window.min() == naive.min());
+			CHECK(window.max() == naive.max());
+		}
+	}
+}
+
+TEST_CASE("sliding_window push_n", "[sliding_window]") {
+	std::vector<float> values { 1, 2, 3, 4, 5, 6, 7, 8 };
+	sliding_window<float, 4> window;
+	window.push(100);
+
+	SECTION("fewer than capacity") {
+		window.push_n(values.begin(), 2);
+		CHECK(window.count() == 3);
+		CHECK(window.max() == 100);
+	}
+
+	SECTION("more than capacity") {
+		window.push_n(values.begin(), (int) values.size());
+		CHECK(window.count() == 4);
+		CHECK(window.sum() == Approx(26));
+		CHECK(window.min() == 5);
+		CHECK(window.max() == 8);
+	}
+}
+
+TEST_CASE("sliding_window constant samples", "[sliding_window]") {
+	sliding_window<double, 8> window;
+	for (int i = 0; i < 100; ++i) window.push(0.1);
+	CHECK(window.variance() >= 0);
+	CHECK(window.stddev() == Approx(0).margin(1e-6));
+}
+
+TEST_CASE("sliding_window operator<<", "[sliding_window]") {
+	sliding_window<int, 4> window;
+	std::ostringstream oss;
+	oss << window;
+	CHECK(oss.str() == "sliding_window<4> {count: 0}");
+	window.push(1);
+	window.push(3);
+	oss.str("");
+	oss << window;
+	CHECK(oss.str() == "sliding_window<4> {count: 2, mean: 2, variance: 1, min: 1, max: 3}");
+}
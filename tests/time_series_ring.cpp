@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/time_series_ring.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+using bsp::time_series_ring;
+using Catch::Equals;
+
+template<typename U> static std::vector<U> flatten(const std::array<bsp::detail_ring_buffer::ring_span<const U>, 2>& segments) {
+	std::vector<U> out;
+	for (const auto& s : segments) out.insert(out.end(), s.begin(), s.end());
+	return out;
+}
+
+TEST_CASE("time_series_ring basics", "[time_series_ring]") {
+	time_series_ring<float, 4> ring;
+	CHECK(ring.empty());
+	CHECK(ring.lower_bound(0) == 0);
+
+	ring.push_back(10, 1.0f);
+	ring.push_back(20, 2.0f);
+	ring.push_back(20, 3.0f);
+	CHECK(ring.count() == 3);
+	CHECK(ring.front_time() == 10);
+	CHECK(ring.back_time() == 20);
+	CHECK(ring.front() == 1.0f);
+	CHECK(ring.back() == 3.0f);
+
+	SECTION("overwrites the oldest sample when full") {
+		ring.push_back(30, 4.0f);
+		ring.push_back(40, 5.0f);
+		CHECK(ring.full());
+		CHECK(ring.front_time() == 20);
+		CHECK_THAT(flatten(ring.value_segments()), Equals(std::vector<float>{ 2, 3, 4, 5 }));
+		CHECK_THAT(flatten(ring.time_segments()), Equals(std::vector<std::int64_t>{ 20, 20, 30, 40 }));
+	}
+
+	SECTION("bounds with duplicate timestamps") {
+		CHECK(ring.lower_bound(5) == 0);
+		CHECK(ring.lower_bound(10) == 0);
+		CHECK(ring.lower_bound(15) == 1);
+		CHECK(ring.lower_bound(20) == 1);
+		CHECK(ring.upper_bound(20) == 3);
+		CHECK(ring.lower_bound(25) == 3);
+	}
+
+	SECTION("operator<<") {
+		std::ostringstream oss;
+		oss << ring;
+		CHECK(oss.str() == "time_series_ring<4> {10: 1, 20: 2, 20: 3}");
+	}
+}
+
+TEST_CASE("time_series_ring range queries across the wrap point", "[time_series_ring]") {
+	// Non power of two capacity, pushed far enough that the samples wrap
+	time_series_ring<int, 7> ring;
+	for (int t = 0; t < 12; ++t) ring.push_back(t * 10, t);
+	REQUIRE(ring.start() != 0);
+	CHECK(ring.front_time() == 50);
+
+	auto r = ring.range(55, 95);
+	CHECK(r.first == 1);
+	CHECK(r.last == 5);
+	CHECK_THAT(flatten(ring.value_segments(r)), Equals(std::vector<int>{ 6, 7, 8, 9 }));
+
+	CHECK(ring.range(0, 40).empty());
+	CHECK(ring.range(200, 300).empty());
+	CHECK(ring.range(90, 50).empty());
+	CHECK(ring.range(0, 1000).size() == 7);
+
+	// Each boundary on both sides of the wrap
+	for (int i = 0; i < ring.count(); ++i) {
+		CHECK(ring.lower_bound(ring.time(i)) == i);
+		CHECK(ring.upper_bound(ring.time(i)) == i + 1);
+		CHECK(ring.lower_bound(ring.time(i) + 1) == i + 1);
+	}
+}
+
+TEST_CASE("time_series_ring expiry", "[time_series_ring]") {
+	time_series_ring<int, 8> ring;
+	for (int t = 0; t < 11; ++t) ring.push_back(t, t);
+
+	CHECK(ring.expire_before(2) == 0);
+	CHECK(ring.expire_older_than(10, 5) == 2);
+	CHECK(ring.front_time() == 5);
+	CHECK(ring.count() == 6);
+	CHECK(ring.expire_before(100) == 6);
+	CHECK(ring.empty());
+
+	ring.push_back(200, 1);
+	CHECK(ring.count() == 1);
+	CHECK(ring.front_time() == 200);
+}
+
+// Has no default constructor
+struct sample {
+	explicit sample(int v) : value(v) {}
+	int value;
+};
+
+TEST_CASE("time_series_ring element lifetimes", "[time_series_ring]") {
+	SECTION("values need not be default constructible") {
+		time_series_ring<sample, 3> ring;
+		for (int t = 0; t < 5; ++t) ring.push_back(t, sample(t * 10));
+		CHECK(ring.front().value == 20);
+		CHECK(ring.back().value == 40);
+	}
+
+	SECTION("values are destroyed when they leave the ring") {
+		auto counter = std::make_shared<int>(0);
+		{
+			time_series_ring<std::shared_ptr<int>, 4> ring;
+			for (int t = 0; t < 6; ++t) ring.push_back(t, counter);
+			CHECK(counter.use_count() == 5);
+			ring.pop_front();
+			CHECK(counter.use_count() == 4);
+			CHECK(ring.expire_before(4) == 1);
+			CHECK(counter.use_count() == 3);
+
+			auto copy = ring;
+			CHECK(counter.use_count() == 5);
+			auto moved = std::move(copy);
+			CHECK(moved.count() == 2);
+			copy = ring;
+			CHECK(counter.use_count() == 7);
+			ring.clear();
+			CHECK(counter.use_count() == 5);
+		}
+		CHECK(counter.use_count() == 1);
+	}
+}
+
+TEST_CASE("time_series_ring for_each_bucket", "[time_series_ring]") {
+	time_series_ring<int, 16> ring;
+	for (int t : { 0, 1, 3, 4, 5, 12, 13, 15, 16, 17, 18, 19 }) ring.push_back(t, t);
+	while (ring.count() < 12) ring.push_back(100, 0); // Unused
+	for (int i = 0; i < 5; ++i) ring.push_back(20 + i, 20 + i); // Wrap around
+
+	std::vector<std::pair<std::int64_t, std::vector<int>>> buckets;
+	ring.for_each_bucket(1, 22, 5, [&](std::int64_t start, time_series_ring<int, 16>::const_value_segments values) {
+		buckets.emplace_back(start, flatten(values));
+	});
+
+	REQUIRE(buckets.size() == 4);
+	CHECK(buckets[0].first == 1);
+	CHECK_THAT(buckets[0].second, Equals(std::vector<int>{ 1, 3, 4, 5 }));
+	CHECK(buckets[1].first == 11); // [6, 11) is empty and skipped
+	CHECK_THAT(buckets[1].second, Equals(std::vector<int>{ 12, 13, 15 }));
+	CHECK(buckets[2].first == 16);
+	CHECK_THAT(buckets[2].second, Equals(std::vector<int>{ 16, 17, 18, 19, 20 }));
+	CHECK(buckets[3].first == 21);
+	CHECK_THAT(buckets[3].second, Equals(std::vector<int>{ 21 }));
+
+	SECTION("floating point timestamps") {
+		time_series_ring<int, 4, double> seconds;
+		seconds.push_back(0.25, 1);
+		seconds.push_back(0.75, 2);
+		seconds.push_back(2.5, 3);
+		std::vector<double> starts;
+		std::vector<int> sums;
+		seconds.for_each_bucket(0.0, 10.0, 0.5, [&](double start, time_series_ring<int, 4, double>::const_value_segments values) {
+			starts.push_back(start);
+			int sum = 0;
+			for (const auto& s : values) sum = std::accumulate(s.begin(), s.end(), sum);
+			sums.push_back(sum);
+		});
+		CHECK_THAT(starts, Equals(std::vector<double>{ 0.0, 0.5, 2.5 }));
+		CHECK_THAT(sums, Equals(std::vector<int>{ 1, 2, 3 }));
+	}
+
+	SECTION("floating point widths that aren't exact") {
+		// 0.6 / 0.1 is just below 6 and 0.7 / 0.1 just above 7, so the quotient alone can't place samples
+		time_series_ring<int, 8, double> seconds;
+		seconds.push_back(0.3, 1);
+		seconds.push_back(0.6, 2);
+		seconds.push_back(0.7, 3);
+		std::vector<double> starts;
+		std::vector<int> counts;
+		seconds.for_each_bucket(0.0, 1.0, 0.1, [&](double start, time_series_ring<int, 8, double>::const_value_segments values) {
+			starts.push_back(start);
+			counts.push_back(static_cast<int>(values[0].size() + values[1].size()));
+		});
+		REQUIRE(starts.size() == 3);
+		CHECK(counts == (std::vector<int>{ 1, 1, 1 }));
+		for (std::size_t i = 0; i < starts.size(); ++i) {
+			CHECK(starts[i] <= seconds.time(static_cast<int>(i)));
+			if (i > 0) CHECK(starts[i - 1] < starts[i]);
+		}
+	}
+}
+
+TEST_CASE("time_series_ring matches linear scan", "[time_series_ring]") {
+	std::default_random_engine engine { 0 };
+	std::uniform_int_distribution<int> step { 0, 3 };
+	time_series_ring<int, 100> ring;
+	std::int64_t now = 0;
+	for (int i = 0; i < 1000; ++i) {
+		now += step(engine);
+		ring.push_back(now, i);
+		if (i % 37 == 0) ring.expire_older_than(now, 150);
+
+		const std::int64_t from = now - step(engine) * 20, to = from + 25;
+		int expected_first = 0;
+		while (expected_first < ring.count() && ring.time(expected_first) < from) expected_first++;
+		int expected_last = expected_first;
+		while (expected_last < ring.count() && ring.time(expected_last) < to) expected_last++;
+		auto r = ring.range(from, to);
+		CHECK(r.first == expected_first);
+		CHECK(r.last == expected_last);
+	}
+}
+
+TEST_CASE("time_series_ring (benchmarks)", "[!benchmark][time_series_ring]") {
+	static const int capacity = 1 << 16;
+	static time_series_ring<float, capacity> ring;
+	for (int i = 0; i < capacity + capacity / 3; ++i) ring.push_back(i, (float) i);
+	const std::int64_t from = ring.front_time() + capacity / 2, to = from + 1000;
+
+	BENCHMARK("range lookup: linear scan") {
+		int first = 0;
+		while (first < ring.count() && ring.time(first) < from) first++;
+		int last = first;
+		while (last < ring.count() && ring.time(last) < to) last++;
+		CHECK(last - first == 1000);
+	}
+
+	BENCHMARK("range lookup: binary search") {
+		auto r = ring.range(from, to);
+		CHECK(r.size() == 1000);
+	}
+}
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BSP_TRACE_ENABLED
+#include "../include/trace.h"
+#include "catch.hpp"
+#include "container_matcher.h"
+
+using bsp::trace_collector;
+using bsp::trace_event;
+using Catch::Equals;
+
+static void traced_work(int depth) {
+	BSP_TRACE_ZONE("traced_work");
+	if (depth > 0) traced_work(depth - 1);
+}
+
+TEST_CASE("trace records zones and counters", "[trace]") {
+	trace_collector& collector = trace_collector::instance();
+	collector.drain();
+
+	traced_work(1);
+	BSP_TRACE_COUNTER("queue depth", 42);
+	BSP_TRACE_BEGIN("manual");
+	BSP_TRACE_END("manual");
+
+	const auto records = collector.drain();
+	REQUIRE(records.size() == 7);
+	std::string phases;
+	for (const auto& r : records) phases += static_cast<char>(r.event.phase);
+	CHECK(phases == "BBEECBE");
+	CHECK(std::string(records[0].event.name) == "traced_work");
+	CHECK(std::string(records[4].event.name) == "queue depth");
+	CHECK(records[4].event.value == 42);
+	CHECK(std::is_sorted(records.begin(), records.end(), [](const trace_collector::record& a, const trace_collector::record& b) {
+		return a.event.timestamp_ns < b.event.timestamp_ns;
+	}));
+	CHECK(std::all_of(records.begin(), records.end(), [&](const trace_collector::record& r) { return r.thread_id == records[0].thread_id; }));
+	CHECK(collector.drain().empty());
+}
+
+TEST_CASE("trace keeps a ring per thread", "[trace]") {
+	trace_collector& collector = trace_collector::instance();
+	collector.drain();
+	const std::size_t dropped_before = collector.dropped();
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([]() {
+			for (int i = 0; i < 100; ++i) traced_work(0);
+		});
+	}
+	for (auto& t : threads) t.join();
+
+	// Rings outlive their threads until drained
+	const auto records = collector.drain();
+	CHECK(records.size() == 4 * 200);
+	std::vector<int> ids;
+	for (const auto& r : records) ids.push_back(r.thread_id);
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+	CHECK(ids.size() == 4);
+	CHECK(collector.dropped() == dropped_before);
+
+	SECTION("drops events when a ring is full") {
+		std::thread([]() {
+			for (int i = 0; i < BSP_TRACE_RING_CAPACITY + 10; ++i) BSP_TRACE_COUNTER("spam", i);
+		}).join();
+		CHECK(collector.dropped() == dropped_before + 10);
+		CHECK(collector.drain().size() == BSP_TRACE_RING_CAPACITY);
+	}
+}
+
+TEST_CASE("trace writes Chrome trace_event JSON", "[trace]") {
+	trace_collector& collector = trace_collector::instance();
+	collector.drain();
+
+	std::thread([]() {
+		BSP_TRACE_THREAD_NAME("worker \"1\"");
+		BSP_TRACE_COUNTER("bytes", 1024);
+	}).join();
+
+	std::ostringstream oss;
+	collector.write_chrome_trace(oss);
+	const std::string json = oss.str();
+	CHECK(json.find("{\"traceEvents\":[") == 0);
+	CHECK(json.find("\"name\":\"thread_name\",\"ph\":\"M\"") != std::string::npos);
+	CHECK(json.find("\"args\":{\"name\":\"worker \\\"1\\\"\"}") != std::string::npos);
+	CHECK(json.find("{\"name\":\"bytes\",\"ph\":\"C\",\"ts\":") != std::string::npos);
+	CHECK(json.find("\"args\":{\"value\":1024}") != std::string::npos);
+	CHECK(json.find("\"displayTimeUnit\":\"ns\"}") != std::string::npos);
+	CHECK(collector.drain().empty());
+}
+
+TEST_CASE("trace (benchmarks)", "[!benchmark][trace]") {
+	static const int num_zones = 1 << 20;
+	trace_collector& collector = trace_collector::instance();
+
+	BENCHMARK("1M empty loop iterations") {
+		int x = 0;
+		for (int i = 0; i < num_zones; ++i) x += i;
+		CHECK(x != 0);
+	}
+
+	BENCHMARK("1M zones, drained every 1024") {
+		for (int i = 0; i < num_zones; ++i) {
+			BSP_TRACE_ZONE("zone");
+			if ((i & 1023) == 0) collector.drain();
+		}
+	}
+
+	collector.drain();
+}